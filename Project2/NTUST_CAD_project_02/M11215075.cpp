@@ -1,36 +1,44 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
-#include <set>
 #include <algorithm>
 #include <limits>
 #include <fstream>
 #include <iomanip>
 #include <string>
+#include <array>
+#include <memory>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include <cstdint>
+#include "geometry.hpp"
+#include "dme.hpp"
+#include "flat_tree.hpp"
+#include "tree_eval.hpp"
+#include "rsmt.hpp"
+#include "task_pool.hpp"
+#include "cts_reader.hpp"
+#include "segment_merge.hpp"
+#include "batch.hpp"
+#include "memory_tracker.hpp"
+#include "buffered_writer.hpp"
+#include "sink_generator.hpp"
+#include "quadrant_kernels.hpp"
+#include "tree_file.hpp"
+#include "eco.hpp"
 using namespace std;
 
-struct Point {
-    int x, y;
-    Point(int x = 0, int y = 0) : x(x), y(y) {}
-    bool operator==(const Point& other) const {
-        return x == other.x && y == other.y;
-    }
-    bool operator<(const Point& other) const {
-        if (x != other.x) return x < other.x;
-        return y < other.y;
-    }
-    bool operator!=(const Point& other) const {
-        return !(*this == other);
-    }
-};
+enum class SynthesisMode { Quadrant, Dme };
 
-struct LineSegment {
-    Point start, end;
-    LineSegment(Point s, Point e) : start(s), end(e) {}
-    bool operator<(const LineSegment& other) const {
-        if (start != other.start) return start < other.start;
-        return end < other.end;
-    }
+// Quality of one synthesized tree
+struct CtsReport {
+    long long t_max = 0, t_min = 0;     // Source-to-sink path lengths
+    long long w_cts = 0, w_flute = 0;   // Tree wire and Steiner baseline
+    double delay_max = 0, delay_min = 0; // Elmore delays in fs
+
+    double skew_ratio() const { return static_cast<double>(t_max) / t_min; }
+    double wire_ratio() const { return w_flute > 0 ? static_cast<double>(w_cts) / w_flute : 1.0; }
 };
 
 class ClockTree {
@@ -38,19 +46,25 @@ private:
     vector<Point> sinks;
     Point source;
     int dimX, dimY;
-    set<LineSegment> segments;
+    FlatTree tree;
+    vector<LineSegment> wires;  // Merged wiring of `tree`, set by evaluate()
+    RcModel rc;
+    int threads = 1;
+    int task_cutoff = 4096;
+    // Quadrant build working set: every subtree owns a contiguous range of
+    // `work`, partitioned in place through the same range of `scratch`
+    PinArrays work, scratch;
+    // Plots with more wires than this are drawn on a coarse grid; 0 = never
+    int plot_detail = 200000;
+    static constexpr int plot_grid = 1024;
 
-    int manhattan_distance(const Point& a, const Point& b) {
-        return abs(a.x - b.x) + abs(a.y - b.y);
+    // Pins are the sinks followed by the source
+    Point pin(int i) const {
+        return i < static_cast<int>(sinks.size()) ? sinks[i] : source;
     }
 
-    void add_manhattan_path(const Point& from, const Point& to) {
-        if (from.x != to.x) {
-            segments.insert(LineSegment(from, Point(to.x, from.y)));
-        }
-        if (from.y != to.y) {
-            segments.insert(LineSegment(Point(to.x, from.y), to));
-        }
+    NodeKind pin_kind(int i) const {
+        return i < static_cast<int>(sinks.size()) ? NodeKind::Sink : NodeKind::Source;
     }
 
     Point find_median_point(vector<Point>& points) {
@@ -65,133 +79,723 @@ private:
         return Point(median_x, median_y);
     }
 
-    Point find_center(const vector<Point>& points) {
-        int sum_x = 0, sum_y = 0;
-        for (const auto& p : points) {
-            sum_x += p.x;
-            sum_y += p.y;
-        }
-        return Point(sum_x / points.size(), sum_y / points.size());
+    Point find_center(int begin, int end) const {
+        return centroid(work.x.data() + begin, work.y.data() + begin, end - begin);
+    }
+
+    NodeKind range_kind(int begin, int end) const {
+        return end - begin == 1 ? pin_kind(work.id[begin]) : NodeKind::Steiner;
     }
 
-    void build_tree(const vector<Point>& points) {
-        if (points.size() <= 1) return;
+    // Grow the subtree of pins [begin, end) of `work` below `center_node` of
+    // `out`, which already sits at their centroid
+    void build_tree(FlatTree& out, int begin, int end, int center_node) {
+        const int n = end - begin;
+        if (n <= 1) return;
         
-        Point center = find_center(points);
+        Point center = out.point(center_node);
         
-        vector<Point> quadrants[4];
-        for (const auto& p : points) {
-            if (p.x <= center.x && p.y <= center.y) quadrants[0].push_back(p);
-            else if (p.x > center.x && p.y <= center.y) quadrants[1].push_back(p);
-            else if (p.x <= center.x && p.y > center.y) quadrants[2].push_back(p);
-            else quadrants[3].push_back(p);
+        array<int, 4> counts = partition_quadrants(
+            work.x.data() + begin, work.y.data() + begin, work.id.data() + begin, n, center,
+            scratch.x.data() + begin, scratch.y.data() + begin, scratch.id.data() + begin);
+
+        // Only coincident pins all land in one quadrant; they cannot be split
+        if (counts[0] == n) {
+            for (int k = begin; k < end; ++k) out.add_node(center.x, center.y, center_node, 0, pin_kind(work.id[k]));
+            return;
         }
         
-        for (int i = 0; i < 4; ++i) {
-            if (!quadrants[i].empty()) {
-                Point quad_center = find_center(quadrants[i]);
-                add_manhattan_path(center, quad_center);
-                build_tree(quadrants[i]);
+        for (int q = 0, from = begin; q < 4; from += counts[q++]) {
+            if (counts[q] == 0) continue;
+            int to = from + counts[q];
+            Point quad_center = find_center(from, to);
+            int node = out.add_node(quad_center.x, quad_center.y, center_node,
+                                    manhattan_distance(center, quad_center), range_kind(from, to));
+            build_tree(out, from, to, node);
+        }
+    }
+
+    // Piece of the quadrant tree built by one task. Small subtrees are built
+    // serially into the running worker's own tree: nodes [begin, end) of
+    // buffers[worker], the first of which is the fragment root. Larger ones
+    // keep only their root here and one child fragment per quadrant.
+    struct Fragment {
+        Point center;
+        int wire = 0;
+        NodeKind kind = NodeKind::Steiner;
+        int worker = -1, begin = 0, end = 0;
+        vector<unique_ptr<Fragment>> children;
+    };
+
+    // Same splits as build_tree with the quadrants as parallel tasks
+    void build_fragment(TaskPool& pool, vector<FlatTree>& buffers, Fragment& fragment,
+                        int begin, int end) {
+        const int n = end - begin;
+        array<int, 4> counts{};
+        if (n >= task_cutoff) counts = split_pins(pool, begin, end, fragment.center);
+
+        // Below the cutoff, and for coincident pins, the serial code is used
+        if (n < task_cutoff || counts[0] == n) {
+            FlatTree& out = buffers[pool.worker()];
+            fragment.worker = pool.worker();
+            fragment.begin = out.size();
+            int node = out.add_node(fragment.center.x, fragment.center.y, -1, 0, fragment.kind);
+            build_tree(out, begin, end, node);
+            fragment.end = out.size();
+            return;
+        }
+
+        TaskPool::Group group;
+        for (int q = 0, from = begin; q < 4; from += counts[q++]) {
+            if (counts[q] == 0) continue;
+            fragment.children.push_back(make_unique<Fragment>());
+            Fragment& child = *fragment.children.back();
+            pool.spawn(group, [&, from, to = from + counts[q], center = fragment.center] {
+                child.center = find_center(from, to);
+                child.wire = manhattan_distance(center, child.center);
+                child.kind = range_kind(from, to);
+                build_fragment(pool, buffers, child, from, to);
+            });
+        }
+        pool.wait(group);
+    }
+
+    // Stable quadrant partition of pins [begin, end) of `work`, done in
+    // chunks for large sets: count per chunk, then every chunk scatters its
+    // pins to its own offsets in `scratch`, so the result matches the serial
+    // partition. Returns the quadrant sizes.
+    array<int, 4> split_pins(TaskPool& pool, int begin, int end, const Point& center) {
+        const int n = end - begin;
+        const int chunks = min(pool.size() * 4, max(1, n / task_cutoff));
+        auto chunk_begin = [&](int c) { return begin + static_cast<int>(n * 1LL * c / chunks); };
+        vector<array<int, 4>> offsets(chunks + 1, array<int, 4>{});
+
+        pool.parallel_for(chunks, [&](int c) {
+            int from = chunk_begin(c);
+            offsets[c + 1] = count_quadrants(work.x.data() + from, work.y.data() + from,
+                                             chunk_begin(c + 1) - from, center);
+        });
+        for (int c = 0; c < chunks; ++c) {
+            for (int q = 0; q < 4; ++q) offsets[c + 1][q] += offsets[c][q];
+        }
+        const array<int, 4> counts = offsets[chunks];
+        array<int, 4> start = {begin, begin + counts[0], begin + counts[0] + counts[1],
+                               begin + counts[0] + counts[1] + counts[2]};
+
+        pool.parallel_for(chunks, [&](int c) {
+            int from = chunk_begin(c);
+            array<int, 4> at;
+            for (int q = 0; q < 4; ++q) at[q] = start[q] + offsets[c][q];
+            scatter_quadrants(work.x.data() + from, work.y.data() + from, work.id.data() + from,
+                              chunk_begin(c + 1) - from, center, at,
+                              scratch.x.data(), scratch.y.data(), scratch.id.data());
+        });
+        pool.parallel_for(chunks, [&](int c) {
+            int from = chunk_begin(c), count = chunk_begin(c + 1) - from;
+            copy_n(scratch.x.data() + from, count, work.x.data() + from);
+            copy_n(scratch.y.data() + from, count, work.y.data() + from);
+            copy_n(scratch.id.data() + from, count, work.id.data() + from);
+        });
+        return counts;
+    }
+
+    // Copy a fragment into `tree` in the order the serial build adds nodes
+    void splice(const vector<FlatTree>& buffers, const Fragment& fragment, int parent) {
+        int node = tree.size();
+        if (fragment.worker < 0) {
+            tree.add_node(fragment.center.x, fragment.center.y, parent, fragment.wire, fragment.kind);
+        } else {
+            const FlatTree& from = buffers[fragment.worker];
+            for (int i = fragment.begin; i < fragment.end; ++i) {
+                bool top = i == fragment.begin;
+                tree.add_node(from.x(i), from.y(i), top ? parent : node + from.parent(i) - fragment.begin,
+                              top ? fragment.wire : from.wire(i), from.kind(i));
             }
         }
+        for (const auto& child : fragment.children) splice(buffers, *child, node);
+    }
+
+    // Every wire of the tree as drawn, with shared and collinear runs merged
+    vector<LineSegment> wiring() const {
+        vector<LineSegment> routed;
+        routed.reserve(2 * tree.size());
+        LineSegment segments[3];
+        for (int i = 0; i < tree.size(); ++i) {
+            int count = tree.edge_segments(i, segments);
+            routed.insert(routed.end(), segments, segments + count);
+        }
+        return merge_collinear(routed);
     }
 
+    // Segments as "x y dx dy" rows of a data block drawn `with vectors`, which
+    // gnuplot reads as plain data instead of parsing one command per wire.
+    // Above plot_detail wires everything is snapped to a plot_grid raster
+    // first; wires collapsing onto the same grid line are merged.
     void generate_plot_script(const string& filename) {
-        ofstream file(filename);
+        BufferedWriter file(filename);
         file << "set xrange [0:" << dimX << "]\n";
         file << "set yrange [0:" << dimY << "]\n";
 
-        for (const auto& seg : segments) {
-            file << "set arrow from " << seg.start.x << "," << seg.start.y 
-                 << " to " << seg.end.x << "," << seg.end.y << " nohead\n";
+        const vector<LineSegment>* drawn = &wires;
+        vector<LineSegment> coarse;
+        vector<Point> sink_marks;
+        int cell = 1;
+        if (plot_detail > 0 && static_cast<int>(wires.size()) > plot_detail) {
+            cell = max(1, (max(dimX, dimY) + plot_grid - 1) / plot_grid);
+            auto snap = [&](Point p) {
+                return Point(min(dimX, (p.x + cell / 2) / cell * cell),
+                             min(dimY, (p.y + cell / 2) / cell * cell));
+            };
+            coarse.reserve(wires.size());
+            for (const LineSegment& seg : wires) coarse.emplace_back(snap(seg.start), snap(seg.end));
+            coarse = merge_collinear(coarse);
+            drawn = &coarse;
+            sink_marks.reserve(sinks.size());
+            for (const Point& sink : sinks) sink_marks.push_back(snap(sink));
+            sort(sink_marks.begin(), sink_marks.end());
+            sink_marks.erase(unique(sink_marks.begin(), sink_marks.end()), sink_marks.end());
+            file << "# Level of detail: " << wires.size() << " wires and " << sinks.size()
+                 << " sinks drawn on a " << cell << "-unit grid\n";
         }
+        const vector<Point>& marks = cell > 1 ? sink_marks : sinks;
 
-        file << "plot '-' with points pt 7 ps 1.5 title 'Sinks', "
-             << "'-' with points pt 7 ps 2 title 'Source'\n";
-        
-        for (const auto& sink : sinks) {
-            file << sink.x << " " << sink.y << endl;
+        file << "$wires << EOD\n";
+        for (const LineSegment& seg : *drawn) {
+            file << seg.start.x << ' ' << seg.start.y << ' ' << seg.end.x - seg.start.x << ' '
+                 << seg.end.y - seg.start.y << '\n';
         }
-        file << "e\n";
-        file << source.x << " " << source.y << endl;
-        file << "e\n";
+        file << "EOD\n$sinks << EOD\n";
+        for (const Point& sink : marks) file << sink.x << ' ' << sink.y << '\n';
+        file << "EOD\n$source << EOD\n" << source.x << ' ' << source.y << "\nEOD\n";
 
+        file << "plot $wires using 1:2:3:4 with vectors nohead lc rgb 'black' notitle, "
+             << "$sinks with points pt 7 ps 1.5 title 'Sinks', "
+             << "$source with points pt 7 ps 2 title 'Source'\n";
         file.close();
     }
 
 public:
-    void read_input(const string& filename) {
-        ifstream file(filename);
-        string line;
-        getline(file, line); // Skip the first line
-        file >> line >> dimX;
-        file >> line >> dimY;
-        int x, y;
-        file >> x >> y;
-        source = Point(x, y);
-        while (file >> x >> y) {
-            if (x == '.' && y == 'e') break;
-            sinks.emplace_back(x, y);
-        }
+    void set_rc_model(const RcModel& model) { rc = model; }
+
+    // Threads for the quadrant build and the pin count below which a subtree
+    // is built serially inside one task
+    void set_parallelism(int thread_count, int cutoff) {
+        threads = max(1, thread_count);
+        task_cutoff = max(2, cutoff);
     }
 
-    void synthesize() {
-        vector<Point> all_points = sinks;
-        all_points.push_back(source);
-        build_tree(all_points);
+    void set_plot_detail(int max_wires) { plot_detail = max(0, max_wires); }
+
+    // Returns the reader for its size and timing
+    CtsReader read_input(const string& filename) {
+        CtsReader reader;
+        CtsDesign design;
+        reader.parse(filename, design);
+        dimX = design.dimX;
+        dimY = design.dimY;
+        source = design.source;
+        sinks = move(design.sinks);
+        return reader;
     }
 
-    void write_output(const string& filename) {
-        ofstream file(filename);
-        file << ".l " << segments.size() << endl;
-        file << ".dimx " << dimX << endl;
-        file << ".dimy " << dimY << endl;
-        for (const auto& seg : segments) {
-            file << seg.start.x << " " << seg.start.y << " "
-                 << seg.end.x << " " << seg.end.y << endl;
+    void synthesize(SynthesisMode mode = SynthesisMode::Quadrant,
+                    Topology topology = Topology::Bisection) {
+        tree.clear();
+        wires.clear();
+        tree.set_die(dimX, dimY);
+
+        if (mode == SynthesisMode::Dme) {
+            DmeRouter router(sinks, source, dimX, dimY, topology);
+            router.run();
+            router.write_tree(tree);
+            return;
         }
-        file << ".e" << endl;
 
-        int t_max = 0, t_min = numeric_limits<int>::max();
-        int w_cts = 0;
-        for (const auto& sink : sinks) {
-            int path_length = manhattan_distance(sink, source);
-            t_max = max(t_max, path_length);
-            t_min = min(t_min, path_length);
+        const int pins = sinks.size() + 1;
+        work.resize(pins);
+        scratch.resize(pins);
+        for (int i = 0; i < pins; ++i) {
+            Point p = pin(i);
+            work.x[i] = p.x;
+            work.y[i] = p.y;
+            work.id[i] = i;
         }
+        tree.reserve(2 * pins);
 
-        for (const auto& seg : segments) {
-            w_cts += manhattan_distance(seg.start, seg.end);
+        // The split grows from the centroid; hang it from the source afterwards
+        Point center = find_center(0, pins);
+        NodeKind kind = pins == 1 ? NodeKind::Source : NodeKind::Steiner;
+        if (threads == 1) {
+            build_tree(tree, 0, pins, tree.add_node(center.x, center.y, -1, 0, kind));
+        } else {
+            // Tasks fill per-worker trees; splicing the fragments back in
+            // serial order reproduces the serial tree exactly
+            TaskPool pool(threads);
+            vector<FlatTree> buffers(pool.size());
+            Fragment root;
+            root.center = center;
+            root.kind = kind;
+            build_fragment(pool, buffers, root, 0, pins);
+            splice(buffers, root, -1);
+        }
+        work = PinArrays();
+        scratch = PinArrays();
+        for (int i = 0; i < tree.size(); ++i) {
+            if (tree.kind(i) == NodeKind::Source) tree.reroot(i);
         }
+    }
+
+    // Path lengths, Elmore delays and wire length of the synthesized tree
+    CtsReport evaluate() {
+        wires = wiring();
 
-        int w_flute = w_cts; // This is a placeholder
+        // Arrival times follow the tree from the source, not straight lines
+        TreeEvaluator evaluator(tree, rc);
+        evaluator.evaluate();
+        CtsReport report;
+        report.t_max = evaluator.max_path();
+        report.t_min = evaluator.min_path();
+        report.delay_max = evaluator.max_delay();
+        report.delay_min = evaluator.min_delay();
 
-        double skew_ratio = static_cast<double>(t_max) / t_min;
-        double wire_length_ratio = static_cast<double>(w_cts) / w_flute;
-        cout << "T_max: " << t_max << ", T_min: " << t_min << ", Skew ratio: " << fixed << setprecision(2) << skew_ratio << endl;
-        cout << "W_cts: " << w_cts << ", W_FLUTE: " << w_flute << ", Wire length ratio: " << fixed << setprecision(2) << wire_length_ratio << endl;
+        report.w_cts = wire_length(wires);
+        // Baseline: a rectilinear Steiner tree over the source and all sinks
+        vector<Point> net = sinks;
+        net.push_back(source);
+        report.w_flute = RsmtEstimator::wirelength(net);
+        return report;
+    }
 
-        file << "T_max: " << t_max << ", T_min: " << t_min << ", Skew ratio: " << fixed << setprecision(2) << skew_ratio << endl;
-        file << "W_cts: " << w_cts << ", W_FLUTE: " << w_flute << ", Wire length ratio: " << fixed << setprecision(2) << wire_length_ratio << endl;
+    // Writes the tree and `report` (from evaluate()) plus the plot script
+    void write_output(const string& filename, const CtsReport& report) {
+        if (wires.empty()) wires = wiring();
+        BufferedWriter file(filename);
+        file << ".l " << wires.size() << '\n';
+        file << ".dimx " << dimX << '\n';
+        file << ".dimy " << dimY << '\n';
+        for (const LineSegment& seg : wires) {
+            file << seg.start.x << ' ' << seg.start.y << ' ' << seg.end.x << ' ' << seg.end.y << '\n';
+        }
+        file << ".e\n";
+        file << "T_max: " << report.t_max << ", T_min: " << report.t_min << ", Skew ratio: " << Fixed{report.skew_ratio(), 2} << '\n';
+        file << "W_cts: " << report.w_cts << ", W_FLUTE: " << report.w_flute << ", Wire length ratio: " << Fixed{report.wire_ratio(), 2} << '\n';
+        file.close();
 
         string gnuplot_filename = filename + ".plt";
         generate_plot_script(gnuplot_filename);
     }
+
+    CtsReport write_output(const string& filename) {
+        CtsReport report = evaluate();
+        write_output(filename, report);
+        return report;
+    }
+
+    int sink_count() const { return sinks.size(); }
+    const FlatTree& get_tree() const { return tree; }
+};
+
+// Applies the changes of `delta_file` to the tree saved in `tree_in`.
+// Writes only the wire that changed to `output`, and the updated tree to
+// `tree_out` when given, so ECOs can be chained.
+int run_eco(const string& delta_file, const string& tree_in, const string& output,
+            const string& tree_out, const RcModel& rc) {
+    try {
+        auto started = chrono::steady_clock::now();
+        FlatTree tree;
+        read_tree_file(tree_in, tree);
+        vector<EcoChange> changes = read_eco_changes(delta_file);
+        double load_s = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+        EcoEditor editor(tree, rc);
+        for (const EcoChange& change : changes) editor.apply(change);
+        vector<LineSegment> removed, added;
+        editor.changed_segments(removed, added);
+
+        const TreeEvaluator& evaluator = editor.evaluation();
+        CtsReport report;
+        report.t_max = evaluator.max_path();
+        report.t_min = evaluator.min_path();
+        report.delay_max = evaluator.max_delay();
+        report.delay_min = evaluator.min_delay();
+        // Unchanged runs cancel, so this is the change in W_cts
+        long long wire_change = wire_length(added) - wire_length(removed);
+
+        BufferedWriter file(output);
+        file << ".removed " << removed.size() << '\n';
+        for (const LineSegment& seg : removed) {
+            file << seg.start.x << ' ' << seg.start.y << ' ' << seg.end.x << ' ' << seg.end.y << '\n';
+        }
+        file << ".added " << added.size() << '\n';
+        for (const LineSegment& seg : added) {
+            file << seg.start.x << ' ' << seg.start.y << ' ' << seg.end.x << ' ' << seg.end.y << '\n';
+        }
+        file << ".e\n";
+        file << "T_max: " << report.t_max << ", T_min: " << report.t_min << ", Skew ratio: " << Fixed{report.skew_ratio(), 2} << '\n';
+        file << "Wire change: " << wire_change << '\n';
+        file.close();
+        if (!tree_out.empty()) write_tree_file(tree_out, tree);
+        double total_s = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+        cout << "Applied " << changes.size() << " changes to " << tree_in << " in " << fixed
+             << setprecision(3) << total_s << " s (" << load_s << " s loading)" << endl;
+        cout << "Segments removed: " << removed.size() << ", added: " << added.size()
+             << ", wire change: " << wire_change << endl;
+        cout << "T_max: " << report.t_max << ", T_min: " << report.t_min << ", Skew ratio: " << setprecision(2) << report.skew_ratio() << endl;
+        cout << "Elmore delay max: " << report.delay_max / 1000 << " ps, min: "
+             << report.delay_min / 1000 << " ps, skew: "
+             << (report.delay_max - report.delay_min) / 1000 << " ps" << endl;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Runs every case of a batch on `jobs` threads, one case per task, and
+// writes one CSV row per case in case order
+int run_batch(const string& source, const string& output_dir, const string& summary_file,
+              int jobs, SynthesisMode mode, Topology topology, const RcModel& rc, int plot_detail) {
+    HeapTracker::enable();
+    vector<BatchCase> cases;
+    try {
+        filesystem::create_directories(output_dir);
+        cases = list_batch_cases(source, output_dir);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+
+    struct Row {
+        string error;
+        int sinks = 0;
+        double seconds = 0;
+        long long peak_bytes = 0;
+        CtsReport report;
+    };
+    vector<Row> rows(cases.size());
+
+    TaskPool pool(jobs);
+    pool.parallel_for(cases.size(), [&](int k) {
+        Row& row = rows[k];
+        HeapTracker::Account account;
+        HeapTracker::Scope charge(account);
+        auto started = chrono::steady_clock::now();
+        try {
+            ClockTree ct;
+            ct.set_rc_model(rc);
+            ct.set_plot_detail(plot_detail);
+            ct.read_input(cases[k].input);
+            row.sinks = ct.sink_count();
+            ct.synthesize(mode, topology);
+            row.report = ct.write_output(cases[k].output);
+        } catch (const exception& e) {
+            row.error = e.what();
+        }
+        row.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        row.peak_bytes = account.peak.load();
+    });
+
+    ofstream summary_stream;
+    if (!summary_file.empty()) {
+        summary_stream.open(summary_file);
+        if (!summary_stream) {
+            cerr << "Error: Cannot write file: " << summary_file << endl;
+            return 1;
+        }
+    }
+    ostream& out = summary_file.empty() ? cout : summary_stream;
+    out << "input,output,status,sinks,seconds,peak_heap_mb,t_max,t_min,skew_ratio,"
+           "w_cts,w_flute,wire_ratio,elmore_skew_ps,error\n";
+    int failed = 0;
+    for (size_t k = 0; k < cases.size(); ++k) {
+        const Row& row = rows[k];
+        const CtsReport& r = row.report;
+        bool ok = row.error.empty();
+        failed += !ok;
+        out << csv_field(cases[k].input) << "," << csv_field(cases[k].output) << ","
+            << (ok ? "ok" : "error") << "," << row.sinks << "," << fixed << setprecision(3)
+            << row.seconds << "," << row.peak_bytes / 1e6 << ",";
+        if (ok) {
+            out << r.t_max << "," << r.t_min << "," << r.skew_ratio() << "," << r.w_cts << ","
+                << r.w_flute << "," << r.wire_ratio() << ","
+                << (r.delay_max - r.delay_min) / 1000 << ",";
+        } else {
+            out << ",,,,,,,";
+        }
+        out << csv_field(row.error) << "\n";
+    }
+    out.flush();
+
+    cerr << cases.size() - failed << " of " << cases.size() << " cases completed" << endl;
+    return failed ? 1 : 0;
+}
+
+struct BenchmarkPlan {
+    vector<int> sizes;
+    vector<SinkPattern> patterns;
+    uint64_t seed = 1;
+    string work_dir, summary_file;
 };
 
+// Generates every pattern at every size and times the phases of one run on
+// it: parse, synthesis, metrics and writing. Each CSV row is flushed as soon
+// as its case ends, so a run that runs out of memory keeps what it measured.
+int run_benchmark(const BenchmarkPlan& plan, SynthesisMode mode, Topology topology,
+                  const RcModel& rc, int threads, int cutoff, int plot_detail) {
+    HeapTracker::enable();
+    ofstream summary_stream;
+    try {
+        filesystem::create_directories(plan.work_dir);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    if (!plan.summary_file.empty()) {
+        summary_stream.open(plan.summary_file);
+        if (!summary_stream) {
+            cerr << "Error: Cannot write file: " << plan.summary_file << endl;
+            return 1;
+        }
+    }
+    ostream& out = plan.summary_file.empty() ? cout : summary_stream;
+    out << "pattern,sinks,seed,mode,threads,kernels,input_mb,generate_s,read_s,read_mb_s,synthesize_s,"
+           "synthesize_ksinks_s,evaluate_s,write_s,output_mb,write_mb_s,peak_rss_mb,peak_heap_mb,tree_mb,"
+           "t_max,t_min,skew_ratio,w_cts,w_flute,wire_ratio,error" << endl;
+
+    auto now = [] { return chrono::steady_clock::now(); };
+    auto since = [](chrono::steady_clock::time_point start) {
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+    auto file_mb = [](const string& name) {
+        error_code ec;
+        auto size = filesystem::file_size(name, ec);
+        return ec ? 0.0 : size / 1e6;
+    };
+
+    int failed = 0;
+    for (SinkPattern pattern : plan.patterns) {
+        for (int size : plan.sizes) {
+            string stem = plan.work_dir + "/" + SinkGenerator::pattern_name(pattern) + "_" +
+                          to_string(size) + "_s" + to_string(plan.seed);
+            string input = stem + ".cts", output = stem + ".out";
+            double generate_s = 0, read_s = 0, synthesize_s = 0, evaluate_s = 0, write_s = 0;
+            double input_mb = 0, output_mb = 0, peak_rss_mb = 0, peak_heap_mb = 0, tree_mb = 0;
+            CtsReport report;
+            string error;
+            cerr << "Benchmark " << SinkGenerator::pattern_name(pattern) << " " << size << endl;
+            try {
+                auto start = now();
+                SinkGenerator::write(input, SinkGenerator::generate(pattern, size, plan.seed));
+                generate_s = since(start);
+                input_mb = file_mb(input);
+
+                RssTracker::reset_peak();
+                HeapTracker::Account account;
+                {
+                    HeapTracker::Scope charge(account);
+                    ClockTree ct;
+                    ct.set_rc_model(rc);
+                    ct.set_parallelism(threads, cutoff);
+                    ct.set_plot_detail(plot_detail);
+                    start = now();
+                    ct.read_input(input);
+                    read_s = since(start);
+                    start = now();
+                    ct.synthesize(mode, topology);
+                    synthesize_s = since(start);
+                    tree_mb = ct.get_tree().memory_bytes() / 1e6;
+                    start = now();
+                    report = ct.evaluate();
+                    evaluate_s = since(start);
+                    start = now();
+                    ct.write_output(output, report);
+                    write_s = since(start);
+                }
+                peak_rss_mb = RssTracker::peak_bytes() / 1e6;
+                peak_heap_mb = account.peak.load() / 1e6;
+                output_mb = file_mb(output) + file_mb(output + ".plt");
+            } catch (const exception& e) {
+                error = e.what();
+                ++failed;
+            }
+
+            out << SinkGenerator::pattern_name(pattern) << "," << size << "," << plan.seed << ","
+                << (mode == SynthesisMode::Dme ? "dme" : "quadrant") << "," << threads << ","
+                << (simd_kernels_enabled() ? "avx2" : "scalar") << ","
+                << fixed << setprecision(3) << input_mb << "," << generate_s << "," << read_s << ","
+                << (read_s > 0 ? input_mb / read_s : 0) << "," << synthesize_s << ","
+                << (synthesize_s > 0 ? size / synthesize_s / 1000 : 0) << "," << evaluate_s << ","
+                << write_s << "," << output_mb << "," << (write_s > 0 ? output_mb / write_s : 0) << ","
+                << peak_rss_mb << "," << peak_heap_mb << "," << tree_mb << ",";
+            if (error.empty()) {
+                out << report.t_max << "," << report.t_min << "," << report.skew_ratio() << ","
+                    << report.w_cts << "," << report.w_flute << "," << report.wire_ratio() << ",";
+            } else {
+                out << ",,,,,,";
+            }
+            out << csv_field(error) << endl;
+        }
+    }
+    return failed ? 1 : 0;
+}
+
+// "1e3,10000,1e5" as positive sink counts
+vector<int> parse_sizes(const string& list) {
+    vector<int> sizes;
+    size_t begin = 0;
+    while (begin <= list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == string::npos) end = list.size();
+        string item = list.substr(begin, end - begin);
+        double value = 0;
+        try {
+            value = stod(item);
+        } catch (const exception&) {
+            throw invalid_argument("Bad sink count: " + item);
+        }
+        if (value < 1 || value > numeric_limits<int>::max() || value != floor(value)) {
+            throw invalid_argument("Bad sink count: " + item);
+        }
+        sizes.push_back(static_cast<int>(value));
+        begin = end + 1;
+    }
+    return sizes;
+}
+
+vector<SinkPattern> parse_patterns(const string& list) {
+    vector<SinkPattern> patterns;
+    size_t begin = 0;
+    while (begin <= list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == string::npos) end = list.size();
+        patterns.push_back(SinkGenerator::parse_pattern(list.substr(begin, end - begin)));
+        begin = end + 1;
+    }
+    return patterns;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        cerr << "Usage: " << argv[0] << " INPUT_FILE OUTPUT_FILE" << endl;
+    SynthesisMode mode = SynthesisMode::Quadrant;
+    Topology topology = Topology::Bisection;
+    bool topology_given = false;
+    RcModel rc;
+    int threads = 1, cutoff = 4096, plot_detail = 200000;
+    string batch_source, output_dir = ".", summary_file;
+    string tree_file, eco_file;
+    string bench_sizes, bench_patterns = "uniform,clustered,macro";
+    uint64_t seed = 1;
+    vector<string> files;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "-m" && i + 1 < argc) {
+            string name = argv[++i];
+            if (name == "quadrant") mode = SynthesisMode::Quadrant;
+            else if (name == "dme") mode = SynthesisMode::Dme;
+            else {
+                cerr << "Unknown mode: " << name << endl;
+                return 1;
+            }
+        } else if (arg == "-t" && i + 1 < argc) {
+            string name = argv[++i];
+            topology_given = true;
+            if (name == "bisection") topology = Topology::Bisection;
+            else if (name == "matching") topology = Topology::Matching;
+            else {
+                cerr << "Unknown topology: " << name << endl;
+                return 1;
+            }
+        } else if (arg == "-r" && i + 1 < argc) {
+            rc.r = stod(argv[++i]);
+        } else if (arg == "-c" && i + 1 < argc) {
+            rc.c = stod(argv[++i]);
+        } else if (arg == "-j" && i + 1 < argc) {
+            threads = stoi(argv[++i]);
+        } else if (arg == "-g" && i + 1 < argc) {
+            cutoff = stoi(argv[++i]);
+        } else if (arg == "-l" && i + 1 < argc) {
+            plot_detail = stoi(argv[++i]);
+        } else if (arg == "-b" && i + 1 < argc) {
+            batch_source = argv[++i];
+        } else if (arg == "-B" && i + 1 < argc) {
+            bench_sizes = argv[++i];
+        } else if (arg == "-P" && i + 1 < argc) {
+            bench_patterns = argv[++i];
+        } else if (arg == "-S" && i + 1 < argc) {
+            seed = stoull(argv[++i]);
+        } else if (arg == "-T" && i + 1 < argc) {
+            tree_file = argv[++i];
+        } else if (arg == "-e" && i + 1 < argc) {
+            eco_file = argv[++i];
+        } else if (arg == "-o" && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if (arg == "-s" && i + 1 < argc) {
+            summary_file = argv[++i];
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    // The quadrant build has no separate topology step to choose
+    if (topology_given && mode != SynthesisMode::Dme) {
+        cerr << "-t applies only to -m dme" << endl;
         return 1;
     }
 
+    if (!bench_sizes.empty() && files.empty()) {
+        BenchmarkPlan plan;
+        try {
+            plan.sizes = parse_sizes(bench_sizes);
+            plan.patterns = parse_patterns(bench_patterns);
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
+        }
+        plan.seed = seed;
+        plan.work_dir = output_dir;
+        plan.summary_file = summary_file;
+        return run_benchmark(plan, mode, topology, rc, threads, cutoff, plot_detail);
+    }
+
+    // Batch cases share the threads between them and build serially
+    if (!batch_source.empty() && files.empty()) {
+        return run_batch(batch_source, output_dir, summary_file, threads, mode, topology, rc, plot_detail);
+    }
+
+    if (files.size() != 2) {
+        cerr << "Usage: " << argv[0] << " [-m quadrant|dme] [-t bisection|matching] [-r OHM_PER_UNIT] [-c FF_PER_UNIT] [-j THREADS] [-g TASK_PINS] [-l PLOT_WIRES] [-T TREE_FILE] INPUT_FILE OUTPUT_FILE" << endl;
+        cerr << "       " << argv[0] << " [options] -b MANIFEST|DIRECTORY [-o OUTPUT_DIR] [-s SUMMARY_CSV]" << endl;
+        cerr << "       " << argv[0] << " [options] -B SIZES [-P uniform,clustered,macro] [-S SEED] [-o WORK_DIR] [-s SUMMARY_CSV]" << endl;
+        cerr << "       " << argv[0] << " -e DELTA_FILE [-T NEW_TREE_FILE] TREE_FILE OUTPUT_FILE" << endl;
+        return 1;
+    }
+
+    if (!eco_file.empty()) return run_eco(eco_file, files[0], files[1], tree_file, rc);
+
     ClockTree ct;
-    ct.read_input(argv[1]);
-    ct.synthesize();
-    ct.write_output(argv[2]);
+    ct.set_rc_model(rc);
+    ct.set_parallelism(threads, cutoff);
+    ct.set_plot_detail(plot_detail);
+    try {
+        CtsReader reader = ct.read_input(files[0]);
+        cout << "Parsed " << files[0] << ": " << reader.get_bytes() << " bytes in "
+             << fixed << setprecision(3) << reader.get_seconds() << " s ("
+             << setprecision(1) << reader.get_throughput() << " MB/s)" << endl;
+        ct.synthesize(mode, topology);
+        CtsReport report = ct.write_output(files[1]);
+        if (!tree_file.empty()) write_tree_file(tree_file, ct.get_tree());
+        cout << "T_max: " << report.t_max << ", T_min: " << report.t_min << ", Skew ratio: " << fixed << setprecision(2) << report.skew_ratio() << endl;
+        cout << "W_cts: " << report.w_cts << ", W_FLUTE: " << report.w_flute << ", Wire length ratio: " << fixed << setprecision(2) << report.wire_ratio() << endl;
+        cout << "Elmore delay max: " << report.delay_max / 1000 << " ps, min: "
+             << report.delay_min / 1000 << " ps, skew: "
+             << (report.delay_max - report.delay_min) / 1000 << " ps" << endl;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
 
-    cout << "Clock tree synthesis completed. Output written to " << argv[2] << endl;
-    cout << "To visualize the result, run: gnuplot " << argv[2] << ".plt" << endl;
+    cout << "Clock tree synthesis completed. Output written to " << files[1] << endl;
+    cout << "To visualize the result, run: gnuplot " << files[1] << ".plt" << endl;
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bump allocator handing out slices of large blocks. Nothing is released
+// individually; everything goes at once on reset() or destruction, so it is
+// only meant for trivially destructible data such as the SoA tree arrays.
+class Arena {
+public:
+    explicit Arena(std::size_t block_size = 1 << 20) : block_size(block_size) {}
+
+    template <typename T>
+    T* allocate(std::size_t count) {
+        // Cache-line alignment keeps parallel arrays from sharing lines
+        std::size_t align = std::max<std::size_t>(alignof(T), 64);
+        return static_cast<T*>(allocate_bytes(count * sizeof(T), align));
+    }
+
+    void reset() {
+        blocks.clear();
+        cursor = limit = 0;
+        reserved = 0;
+    }
+
+    // Bytes obtained from the system, including unused block tails
+    std::size_t bytes_reserved() const { return reserved; }
+
+private:
+    std::size_t block_size;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::uintptr_t cursor = 0, limit = 0;
+    std::size_t reserved = 0;
+
+    void* allocate_bytes(std::size_t bytes, std::size_t align) {
+        std::uintptr_t start = (cursor + align - 1) & ~(align - 1);
+        if (blocks.empty() || start + bytes > limit) {
+            std::size_t size = std::max(block_size, bytes + align);
+            blocks.emplace_back(new char[size]);
+            cursor = reinterpret_cast<std::uintptr_t>(blocks.back().get());
+            limit = cursor + size;
+            reserved += size;
+            start = (cursor + align - 1) & ~(align - 1);
+        }
+        cursor = start + bytes;
+        return reinterpret_cast<void*>(start);
+    }
+};
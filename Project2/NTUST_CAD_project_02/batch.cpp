@@ -0,0 +1,63 @@
+#include "batch.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+using namespace std;
+namespace fs = std::filesystem;
+
+vector<BatchCase> list_batch_cases(const string& source, const string& output_dir) {
+    auto default_output = [&](const fs::path& input) {
+        return (fs::path(output_dir) / input.stem()).string() + ".out";
+    };
+
+    vector<BatchCase> cases;
+    if (fs::is_directory(source)) {
+        vector<fs::path> inputs;
+        for (const auto& entry : fs::directory_iterator(source)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".cts") {
+                inputs.push_back(entry.path());
+            }
+        }
+        sort(inputs.begin(), inputs.end());
+        for (const fs::path& input : inputs) cases.push_back({input.string(), default_output(input)});
+    } else {
+        ifstream manifest(source);
+        if (!manifest) throw runtime_error("Cannot open manifest: " + source);
+        fs::path base = fs::path(source).parent_path();
+        string line;
+        while (getline(manifest, line)) {
+            line = line.substr(0, line.find('#'));
+            istringstream fields(line);
+            string input, output;
+            if (!(fields >> input)) continue;
+            fs::path input_path = fs::path(input).is_absolute() ? fs::path(input) : base / input;
+            if (fields >> output) {
+                fs::path output_path = fs::path(output).is_absolute() ? fs::path(output) : base / output;
+                cases.push_back({input_path.string(), output_path.string()});
+            } else {
+                cases.push_back({input_path.string(), default_output(input_path)});
+            }
+        }
+    }
+
+    set<string> outputs;
+    for (const BatchCase& c : cases) {
+        if (!outputs.insert(fs::weakly_canonical(c.output).string()).second) {
+            throw runtime_error("Two batch cases write " + c.output);
+        }
+    }
+    return cases;
+}
+
+string csv_field(const string& text) {
+    if (text.find_first_of(",\"\n\r") == string::npos) return text;
+    string quoted = "\"";
+    for (char ch : text) {
+        if (ch == '"') quoted += '"';
+        quoted += ch;
+    }
+    return quoted + "\"";
+}
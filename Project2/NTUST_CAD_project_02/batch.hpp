@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include <vector>
+
+struct BatchCase {
+    std::string input, output;
+};
+
+// Cases of a batch run. `source` is either a directory, whose *.cts files
+// are taken in name order, or a manifest with one "INPUT [OUTPUT]" per line
+// ('#' starts a comment; relative paths are relative to the manifest).
+// Outputs default to <output_dir>/<input stem>.out. Throws runtime_error
+// for unreadable sources and for two cases writing the same output.
+std::vector<BatchCase> list_batch_cases(const std::string& source, const std::string& output_dir);
+
+// Quote a CSV field when it contains a separator, quote or line break
+std::string csv_field(const std::string& text);
@@ -0,0 +1,85 @@
+#include "buffered_writer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+using namespace std;
+
+namespace {
+void write_all(int fd, const char* data, size_t size, const string& filename) {
+    while (size > 0) {
+        ssize_t wrote = write(fd, data, size);
+        if (wrote < 0) {
+            if (errno == EINTR) continue;
+            throw runtime_error("Cannot write file: " + filename);
+        }
+        data += wrote;
+        size -= wrote;
+    }
+}
+}
+
+BufferedWriter::BufferedWriter(const string& filename, size_t capacity)
+    : filename(filename), buffer(max<size_t>(capacity, 64)) {
+    fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw runtime_error("Cannot write file: " + filename);
+}
+
+BufferedWriter::~BufferedWriter() {
+    if (fd < 0) return;
+    try {
+        flush();
+    } catch (const exception&) {
+    }
+    ::close(fd);
+}
+
+BufferedWriter& BufferedWriter::operator<<(string_view text) {
+    if (text.size() > buffer.size() - used) {
+        flush();
+        // Too big to stage: hand it to the file as is
+        if (text.size() > buffer.size()) {
+            write_all(fd, text.data(), text.size(), filename);
+            return *this;
+        }
+    }
+    memcpy(buffer.data() + used, text.data(), text.size());
+    used += text.size();
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(char c) {
+    reserve(1);
+    buffer[used++] = c;
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(Fixed number) {
+    // Room for any double in fixed notation
+    char digits[512];
+    auto result = to_chars(digits, digits + sizeof(digits), number.value, chars_format::fixed,
+                           min(number.precision, 100));
+    return *this << string_view(digits, result.ptr - digits);
+}
+
+void BufferedWriter::flush() {
+    size_t size = used;
+    used = 0;
+    write_all(fd, buffer.data(), size, filename);
+}
+
+void BufferedWriter::close() {
+    if (fd < 0) return;
+    try {
+        flush();
+    } catch (const exception&) {
+        ::close(fd);
+        fd = -1;
+        throw;
+    }
+    int status = ::close(fd);
+    fd = -1;
+    if (status != 0) throw runtime_error("Cannot write file: " + filename);
+}
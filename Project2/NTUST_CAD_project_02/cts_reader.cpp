@@ -0,0 +1,58 @@
+#include "cts_reader.hpp"
+#include "mapped_file.hpp"
+#include "tokenizer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+using namespace std;
+
+void CtsReader::parse(const string& filename, CtsDesign& design) {
+    auto started = chrono::steady_clock::now();
+    MappedFile file(filename);
+    Tokenizer tokens(file.begin(), file.end(), filename);
+
+    design = CtsDesign();
+    long long declared = -1;
+    bool has_source = false, terminated = false;
+    while (tokens.next()) {
+        if (tokens.at_keyword()) {
+            string_view keyword = tokens.word();
+            if (keyword == ".e") {
+                terminated = true;
+                break;
+            } else if (keyword == ".p") {
+                declared = tokens.integer();
+                if (declared < 0) tokens.fail("negative pin count");
+                design.sinks.reserve(max(0LL, declared - 1));
+            } else if (keyword == ".dimx") {
+                design.dimX = tokens.integer();
+            } else if (keyword == ".dimy") {
+                design.dimY = tokens.integer();
+            } else {
+                tokens.fail("unknown keyword " + string(keyword));
+            }
+            continue;
+        }
+
+        // The first point is the source, the rest are sinks
+        int x = tokens.integer();
+        int y = tokens.integer();
+        if (has_source) {
+            design.sinks.emplace_back(x, y);
+        } else {
+            design.source = Point(x, y);
+            has_source = true;
+        }
+    }
+
+    if (!has_source) tokens.fail("no source point");
+    if (!terminated) cerr << "Warning: " << filename << " has no .e terminator" << endl;
+    long long pins = design.sinks.size() + 1;
+    if (declared >= 0 && declared != pins) {
+        cerr << "Warning: " << filename << " declares " << declared << " pins but lists "
+             << pins << endl;
+    }
+
+    bytes = file.size();
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+}
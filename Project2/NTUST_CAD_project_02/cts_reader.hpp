@@ -0,0 +1,28 @@
+#pragma once
+#include "geometry.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct CtsDesign {
+    int dimX = 0, dimY = 0;
+    Point source;
+    std::vector<Point> sinks;
+};
+
+// Reader for .cts files: ".p N" (source and sinks), ".dimx X", ".dimy Y",
+// the source and sink coordinates, then ".e". The file is mapped and
+// tokenised in place with from_chars; the sink vector is sized from ".p".
+// Malformed input throws runtime_error naming the line.
+class CtsReader {
+public:
+    void parse(const std::string& filename, CtsDesign& design);
+
+    std::size_t get_bytes() const { return bytes; }
+    double get_seconds() const { return seconds; }
+    double get_throughput() const { return seconds > 0 ? bytes / seconds / 1e6 : 0.0; }  // MB/s
+
+private:
+    std::size_t bytes = 0;
+    double seconds = 0;
+};
@@ -0,0 +1,267 @@
+#include "dme.hpp"
+#include "kdtree.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+using namespace std;
+
+DmeRouter::DmeRouter(const vector<Point>& sinks, const Point& source, int dimX, int dimY,
+                     Topology topology)
+    : sinks(sinks), source(source), dimX(dimX), dimY(dimY), topology(topology) {}
+
+void DmeRouter::run() {
+    nodes.clear();
+    target_latency = 0;
+    if (sinks.empty()) return;
+
+    if (topology == Topology::Matching) {
+        build_matching();
+    } else {
+        build_bisection();
+        merge_bottom_up();
+    }
+    embed_top_down();
+}
+
+void DmeRouter::build_bisection() {
+    const int n = sinks.size();
+    nodes.reserve(2 * n - 1);
+    nodes.emplace_back();
+
+    vector<int> order(n);
+    iota(order.begin(), order.end(), 0);
+
+    // Explicit work stack instead of recursion: [lo, hi) of `order` -> node
+    struct Task { int lo, hi, node; };
+    vector<Task> stack;
+    stack.push_back({0, n, 0});
+
+    while (!stack.empty()) {
+        Task task = stack.back();
+        stack.pop_back();
+
+        if (task.hi - task.lo == 1) {
+            nodes[task.node].sink = order[task.lo];
+            continue;
+        }
+
+        // Cut the wider side of the bounding box at the median
+        int min_x = dimX, max_x = 0, min_y = dimY, max_y = 0;
+        for (int i = task.lo; i < task.hi; ++i) {
+            const Point& p = sinks[order[i]];
+            min_x = min(min_x, p.x);
+            max_x = max(max_x, p.x);
+            min_y = min(min_y, p.y);
+            max_y = max(max_y, p.y);
+        }
+        bool cut_x = (max_x - min_x) >= (max_y - min_y);
+
+        int mid = task.lo + (task.hi - task.lo) / 2;
+        nth_element(order.begin() + task.lo, order.begin() + mid, order.begin() + task.hi,
+                    [&](int a, int b) {
+                        return cut_x ? sinks[a].x < sinks[b].x : sinks[a].y < sinks[b].y;
+                    });
+
+        int left = nodes.size();
+        nodes.emplace_back();
+        nodes.emplace_back();
+        nodes[task.node].left = left;
+        nodes[task.node].right = left + 1;
+
+        stack.push_back({mid, task.hi, left + 1});
+        stack.push_back({task.lo, mid, left});
+    }
+}
+
+void DmeRouter::merge_bottom_up() {
+    // Children are always created after their parent
+    for (int i = static_cast<int>(nodes.size()) - 1; i >= 0; --i) {
+        merge(i);
+    }
+}
+
+void DmeRouter::build_matching() {
+    const int n = sinks.size();
+    nodes.resize(2 * n - 1);
+
+    // Built leaves-first; reversed at the end to restore parent-first order
+    vector<int> active(n);
+    for (int i = 0; i < n; ++i) {
+        nodes[i].sink = i;
+        merge(i);
+        active[i] = i;
+    }
+
+    // Subtrees live in (u, v, delay) space: the Chebyshev distance there is
+    // max(separation, delay difference), the wire a merge will cost
+    auto key = [this](int i) {
+        const Node& node = nodes[i];
+        return KdTree::Item{{(node.ms.ulo + node.ms.uhi) / 2, (node.ms.vlo + node.ms.vhi) / 2,
+                             node.delay}, i};
+    };
+
+    int next = n;
+    KdTree index;
+    vector<KdTree::Item> items;
+    vector<char> matched(2 * n - 1, 0);
+    vector<tuple<double, int, int>> candidates;
+
+    while (active.size() > 1) {
+        items.clear();
+        for (int i : active) items.push_back(key(i));
+        index.build(move(items));
+
+        // Closest pairs first. A subtree whose partner was taken re-queries
+        // the shrinking index, but only settles for an equally close one;
+        // otherwise it waits a round and may pair with a merged subtree,
+        // which keeps far-apart forced pairs out of the topology. Since a
+        // re-query never returns anything closer than the candidate being
+        // scanned, one sort replaces a priority queue.
+        candidates.clear();
+        for (const auto& item : index.get_items()) {
+            double dist;
+            int other = index.nearest(item.c, item.id, dist);
+            if (other >= 0) candidates.emplace_back(dist, item.id, other);
+        }
+        sort(candidates.begin(), candidates.end());
+
+        vector<int> merged;
+        merged.reserve(active.size() / 2 + 1);
+        for (auto [dist, a, b] : candidates) {
+            if (matched[a]) continue;
+            while (b >= 0 && matched[b]) {
+                double next_dist;
+                b = index.nearest(key(a).c, a, next_dist);
+                if (next_dist > dist) b = -1;
+            }
+            if (b < 0) continue;
+
+            matched[a] = matched[b] = 1;
+            index.erase(a);
+            index.erase(b);
+            nodes[next].left = a;
+            nodes[next].right = b;
+            merge(next);
+            merged.push_back(next++);
+        }
+
+        // An odd subtree out waits for the next round
+        for (int i : active) {
+            if (!matched[i]) merged.push_back(i);
+        }
+        active.swap(merged);
+    }
+
+    // Reverse so the root is node 0 and children follow their parent
+    const int total = nodes.size();
+    reverse(nodes.begin(), nodes.end());
+    for (auto& node : nodes) {
+        if (node.left >= 0) {
+            node.left = total - 1 - node.left;
+            node.right = total - 1 - node.right;
+        }
+    }
+}
+
+void DmeRouter::merge(int i) {
+    Node& node = nodes[i];
+    if (node.left < 0) {
+        const Point& p = sinks[node.sink];
+        double u = p.x + p.y, v = p.x - p.y;
+        node.ms = {u, u, v, v};
+        node.delay = 0;
+        return;
+    }
+
+    Node& a = nodes[node.left];
+    Node& b = nodes[node.right];
+    double d = distance(a.ms, b.ms);
+
+    // Zero-skew split of the connecting wire; a negative share means the
+    // other side has to snake to catch up
+    double ea = (d + b.delay - a.delay) / 2;
+    double eb = d - ea;
+    if (ea < 0) {
+        ea = 0;
+        eb = a.delay - b.delay;
+    } else if (eb < 0) {
+        eb = 0;
+        ea = b.delay - a.delay;
+    }
+
+    a.edge = ea;
+    b.edge = eb;
+    node.ms = intersect(expand(a.ms, ea), expand(b.ms, eb));
+    node.delay = a.delay + ea;
+}
+
+void DmeRouter::embed_top_down() {
+    Node& root = nodes[0];
+    root.pos = nearest_point(root.ms, source);
+    root.arrival = manhattan_distance(source, root.pos);
+    root.wire = root.arrival;
+    target_latency = root.arrival + llround(root.delay);
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const Node& parent = nodes[i];
+        if (parent.left < 0) continue;
+
+        for (int c : {parent.left, parent.right}) {
+            Node& child = nodes[c];
+            child.parent = i;
+            child.pos = nearest_point(child.ms, parent.pos);
+
+            // Aim at the common target rather than the merged edge length so
+            // rounding errors made higher up are absorbed further down
+            long long length = manhattan_distance(parent.pos, child.pos);
+            long long wanted = target_latency - parent.arrival - llround(child.delay);
+            if (wanted > length && child.pos != parent.pos) {
+                length += (wanted - length + 1) / 2 * 2;  // detours come in pairs
+            }
+
+            child.wire = length;
+            child.arrival = parent.arrival + length;
+        }
+    }
+}
+
+void DmeRouter::write_tree(FlatTree& tree) const {
+    tree.reserve(tree.size() + nodes.size() + 1);
+    int base = tree.add_node(source.x, source.y, -1, 0, NodeKind::Source) + 1;
+
+    // Parents precede children, so node i lands at base + i
+    for (const auto& node : nodes) {
+        int parent = node.parent < 0 ? base - 1 : base + node.parent;
+        tree.add_node(node.pos.x, node.pos.y, parent, node.wire,
+                      node.left < 0 ? NodeKind::Sink : NodeKind::Steiner);
+    }
+}
+
+double DmeRouter::distance(const Region& a, const Region& b) {
+    double du = max({0.0, b.ulo - a.uhi, a.ulo - b.uhi});
+    double dv = max({0.0, b.vlo - a.vhi, a.vlo - b.vhi});
+    return max(du, dv);
+}
+
+DmeRouter::Region DmeRouter::expand(const Region& r, double radius) {
+    return {r.ulo - radius, r.uhi + radius, r.vlo - radius, r.vhi + radius};
+}
+
+DmeRouter::Region DmeRouter::intersect(const Region& a, const Region& b) {
+    Region r = {max(a.ulo, b.ulo), min(a.uhi, b.uhi), max(a.vlo, b.vlo), min(a.vhi, b.vhi)};
+    // Collapse floating-point slivers back onto a line
+    if (r.ulo > r.uhi) r.ulo = r.uhi = (r.ulo + r.uhi) / 2;
+    if (r.vlo > r.vhi) r.vlo = r.vhi = (r.vlo + r.vhi) / 2;
+    return r;
+}
+
+Point DmeRouter::nearest_point(const Region& r, const Point& p) const {
+    // Clamping each rotated axis independently minimises the Chebyshev
+    // (= Manhattan) distance
+    double u = min(max(double(p.x + p.y), r.ulo), r.uhi);
+    double v = min(max(double(p.x - p.y), r.vlo), r.vhi);
+    int x = static_cast<int>(llround((u + v) / 2));
+    int y = static_cast<int>(llround((u - v) / 2));
+    return Point(min(max(x, 0), dimX), min(max(y, 0), dimY));
+}
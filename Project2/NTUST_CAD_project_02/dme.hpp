@@ -0,0 +1,64 @@
+#pragma once
+#include "flat_tree.hpp"
+#include "geometry.hpp"
+#include <vector>
+
+// Deferred-Merge Embedding (DME) zero-skew clock routing under the linear
+// delay model, i.e. the arrival time of a sink is its path length.
+//
+// The topology is a binary tree built either by recursive median bisection
+// (method of means and medians) or by greedy nearest-neighbour matching of
+// merging regions. All passes run over a flat node array whose children
+// always have larger indices than their parent, so the bottom-up merge is a
+// reverse scan and the top-down embedding a forward scan; nothing recurses
+// on the tree, and the whole engine runs in O(n log n) per matching round.
+enum class Topology { Bisection, Matching };
+
+class DmeRouter {
+public:
+    DmeRouter(const std::vector<Point>& sinks, const Point& source, int dimX, int dimY,
+              Topology topology = Topology::Bisection);
+
+    // Build topology, compute merging regions and embed the tree
+    void run();
+
+    // Append the embedded tree, rooted at the source, to an empty tree
+    void write_tree(FlatTree& tree) const;
+
+private:
+    // Tilted rectangle stored in rotated coordinates u = x + y, v = x - y,
+    // where the Manhattan metric becomes the Chebyshev metric
+    struct Region {
+        double ulo, uhi, vlo, vhi;
+    };
+
+    struct Node {
+        int left = -1, right = -1;  // Children, -1 for a sink
+        int parent = -1;
+        int sink = -1;              // Index into sinks for leaves
+        Region ms;                  // Merging region
+        double delay = 0;           // Latency from this node down to its sinks
+        double edge = 0;            // Wire length to the parent as merged
+        Point pos;                  // Embedded location
+        int wire = 0;               // Routed wire length to the parent
+        long long arrival = 0;      // Realised latency from the source
+    };
+
+    const std::vector<Point>& sinks;
+    Point source;
+    int dimX, dimY;
+    Topology topology;
+    std::vector<Node> nodes;
+    long long target_latency = 0;
+
+    void build_bisection();
+    void merge_bottom_up();
+    void build_matching();
+    void merge(int i);
+    void embed_top_down();
+
+    static double distance(const Region& a, const Region& b);
+    static Region expand(const Region& r, double radius);
+    static Region intersect(const Region& a, const Region& b);
+    Point nearest_point(const Region& r, const Point& p) const;
+};
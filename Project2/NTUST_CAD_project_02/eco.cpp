@@ -0,0 +1,342 @@
+#include "eco.hpp"
+#include "mapped_file.hpp"
+#include "segment_merge.hpp"
+#include "tokenizer.hpp"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+using namespace std;
+
+vector<EcoChange> read_eco_changes(const string& filename) {
+    MappedFile file(filename);
+    Tokenizer tokens(file.begin(), file.end(), filename);
+
+    vector<EcoChange> changes;
+    while (tokens.next()) {
+        if (!tokens.at_keyword()) tokens.fail("expected .add, .remove, .move or .e");
+        string_view keyword = tokens.word();
+        if (keyword == ".e") break;
+
+        EcoChange change;
+        if (keyword == ".add") {
+            change.action = EcoAction::Add;
+        } else if (keyword == ".remove") {
+            change.action = EcoAction::Remove;
+        } else if (keyword == ".move") {
+            change.action = EcoAction::Move;
+        } else {
+            tokens.fail("unknown keyword " + string(keyword));
+        }
+        change.at.x = tokens.integer();
+        change.at.y = tokens.integer();
+        if (change.action == EcoAction::Move) {
+            change.to.x = tokens.integer();
+            change.to.y = tokens.integer();
+        }
+        changes.push_back(change);
+    }
+    return changes;
+}
+
+EcoEditor::EcoEditor(FlatTree& tree, RcModel model) : tree(tree), evaluator(tree, model) {
+    const int n = tree.size();
+    evaluator.evaluate();
+    earliest = evaluator.min_path();
+    latest = evaluator.max_path();
+    fastest = evaluator.min_delay();
+    slowest = evaluator.max_delay();
+    latency.resize(n);
+    delay.resize(n);
+    for (int i = 0; i < n; ++i) {
+        latency[i] = evaluator.path_length(i);
+        delay[i] = evaluator.elmore_delay(i);
+    }
+    touched.assign(n, 0);
+    build_grid();
+}
+
+void EcoEditor::build_grid() {
+    int count = 0;
+    Point low(INT_MAX, INT_MAX), high(INT_MIN, INT_MIN);
+    for (int i = 0; i < tree.size(); ++i) {
+        if (!attached(i)) continue;
+        const Point p = tree.point(i);
+        low = Point(min(low.x, p.x), min(low.y, p.y));
+        high = Point(max(high.x, p.x), max(high.y, p.y));
+        ++count;
+    }
+    if (count == 0) return;
+
+    // About four nodes per cell
+    double area = (high.x - low.x + 1.0) * (high.y - low.y + 1.0);
+    origin = low;
+    cell_size = max(1, static_cast<int>(ceil(sqrt(4 * area / count))));
+    columns = (high.x - low.x) / cell_size + 1;
+    rows = (high.y - low.y) / cell_size + 1;
+    cells.assign(static_cast<size_t>(columns) * rows, {});
+    for (int i = 0; i < tree.size(); ++i) {
+        if (attached(i)) index(i);
+    }
+}
+
+int EcoEditor::cell_column(int x) const {
+    long long cell = (static_cast<long long>(x) - origin.x) / cell_size;
+    return static_cast<int>(clamp<long long>(cell, 0, columns - 1));
+}
+
+int EcoEditor::cell_row(int y) const {
+    long long cell = (static_cast<long long>(y) - origin.y) / cell_size;
+    return static_cast<int>(clamp<long long>(cell, 0, rows - 1));
+}
+
+void EcoEditor::index(int node) {
+    if (cells.empty()) cells.assign(1, {});
+    const Point p = tree.point(node);
+    cells[static_cast<size_t>(cell_row(p.y)) * columns + cell_column(p.x)].push_back(node);
+}
+
+void EcoEditor::unindex(int node) {
+    const Point p = tree.point(node);
+    vector<int>& cell = cells[static_cast<size_t>(cell_row(p.y)) * columns + cell_column(p.x)];
+    auto it = find(cell.begin(), cell.end(), node);
+    *it = cell.back();
+    cell.pop_back();
+}
+
+void EcoEditor::touch(int node) {
+    if (touched[node]) return;
+    touched[node] = 1;
+    touched_nodes.push_back(node);
+    LineSegment segments[3];
+    int count = tree.edge_segments(node, segments);
+    before.insert(before.end(), segments, segments + count);
+}
+
+int EcoEditor::add_node(const Point& at, int parent, long long wire, NodeKind kind) {
+    int node = tree.add_node(at.x, at.y, parent, static_cast<int>(wire), kind);
+    latency.push_back(latency[parent] + wire);
+    delay.push_back(delay[parent] + wire_delay(wire));
+    // New wire only: nothing was routed here before
+    touched.push_back(1);
+    touched_nodes.push_back(node);
+    index(node);
+    return node;
+}
+
+double EcoEditor::wire_delay(long long wire) const {
+    const RcModel& rc = evaluator.rc_model();
+    return rc.r * wire * (rc.c * wire / 2 + rc.sink_cap);
+}
+
+EcoEditor::Tap EcoEditor::tap_from(int node, const Point& at) const {
+    Tap tap;
+    tap.wire = max<long long>(manhattan_distance(tree.point(node), at), earliest - latency[node]);
+
+    // Snake on until the sink is no faster than the fastest one: solve
+    // r w (c w / 2 + sink_cap) = lag for w
+    double lag = fastest - delay[node];
+    if (lag > wire_delay(tap.wire)) {
+        const RcModel& rc = evaluator.rc_model();
+        double a = rc.r * rc.c / 2, b = rc.r * rc.sink_cap;
+        if (a > 0 || b > 0) {
+            double w = a > 0 ? (sqrt(b * b + 4 * a * lag) - b) / (2 * a) : lag / b;
+            tap.wire = max(tap.wire, static_cast<long long>(ceil(w)));
+            if (wire_delay(tap.wire) < lag) ++tap.wire;
+        }
+    }
+    tap.delay = delay[node] + wire_delay(tap.wire);
+    long long late = latency[node] + tap.wire - latest;
+    double slow = tap.delay - slowest;
+    if (late > 0) tap.excess += static_cast<double>(late) / max<long long>(latest, 1);
+    if (slow > 0) tap.excess += slow / max(slowest, 1.0);
+    return tap;
+}
+
+void EcoEditor::apply(const EcoChange& change) {
+    if (change.action == EcoAction::Add) {
+        add_sink(change.at);
+        return;
+    }
+    int node = find_sink(change.at);
+    if (change.action == EcoAction::Move && move_sink(node, change.to)) return;
+    remove_sink(node);
+    if (change.action == EcoAction::Move) add_sink(change.to);
+}
+
+int EcoEditor::find_sink(const Point& at) const {
+    int found = -1;
+    if (!cells.empty()) {
+        for (int i : cells[static_cast<size_t>(cell_row(at.y)) * columns + cell_column(at.x)]) {
+            if (tree.kind(i) == NodeKind::Sink && tree.parent(i) >= 0 && tree.point(i) == at &&
+                (found < 0 || i < found)) {
+                found = i;
+            }
+        }
+    }
+    if (found < 0) throw runtime_error("No sink at " + to_string(at.x) + " " + to_string(at.y));
+    return found;
+}
+
+bool EcoEditor::move_sink(int node, const Point& to) {
+    if (tree.first_child(node) >= 0) return false;
+    int parent = tree.parent(node);
+    Tap tap = tap_from(parent, to);
+    if (tap.excess > 0) return false;
+
+    touch(node);
+    unindex(node);
+    tree.set_point(node, to);
+    tree.set_wire(node, static_cast<int>(tap.wire));
+    latency[node] = latency[parent] + tap.wire;
+    delay[node] = tap.delay;
+    index(node);
+    if (!reshaped) {
+        evaluator.update_subtree(node);
+        incremental = true;
+    }
+    return true;
+}
+
+void EcoEditor::remove_sink(int node) {
+    reshaped = true;
+    // A sink with a subtree below it stays as a Steiner point
+    if (tree.first_child(node) >= 0) {
+        tree.set_kind(node, NodeKind::Steiner);
+        return;
+    }
+    // Detached nodes stay in their cells and are skipped there
+    while (node != tree.get_root() && tree.first_child(node) < 0) {
+        int parent = tree.parent(node);
+        touch(node);
+        tree.set_parent(node, -1, 0);
+        if (tree.kind(parent) != NodeKind::Steiner) break;
+        node = parent;
+    }
+}
+
+void EcoEditor::add_sink(const Point& at) {
+    reshaped = true;
+    // Least excess, then least wire, then lowest index
+    int tap = -1;
+    Tap best;
+    auto consider = [&](int i) {
+        if (!attached(i)) return;
+        Tap t = tap_from(i, at);
+        bool better = tap < 0 || t.excess < best.excess ||
+                      (t.excess == best.excess &&
+                       (t.wire < best.wire || (t.wire == best.wire && i < tap)));
+        if (better) {
+            tap = i;
+            best = t;
+        }
+    };
+
+    // Rings of cells around `at`; a node in ring k is at least
+    // (k - 1) * cell_size + 1 away, and no wire is shorter than that
+    const int qc = cell_column(at.x), qr = cell_row(at.y);
+    for (int k = 0; k <= max(columns, rows); ++k) {
+        long long nearest = k > 0 ? static_cast<long long>(k - 1) * cell_size + 1 : 0;
+        if (tap >= 0 && best.excess == 0 && nearest > best.wire) break;
+        for (int r = max(0, qr - k); r <= min(rows - 1, qr + k); ++r) {
+            const vector<int>* row = &cells[static_cast<size_t>(r) * columns];
+            if (r == qr - k || r == qr + k) {
+                for (int c = max(0, qc - k); c <= min(columns - 1, qc + k); ++c) {
+                    for (int i : row[c]) consider(i);
+                }
+                continue;
+            }
+            if (qc - k >= 0) {
+                for (int i : row[qc - k]) consider(i);
+            }
+            if (qc + k < columns) {
+                for (int i : row[qc + k]) consider(i);
+            }
+        }
+    }
+
+    if (tree.kind(tap) == NodeKind::Sink) {
+        // The Steiner tap takes over the sink's wire, so no path changes
+        touch(tap);
+        int steiner = add_node(tree.point(tap), tree.parent(tap), tree.wire(tap), NodeKind::Steiner);
+        delay[steiner] = delay[tap];
+        tree.set_parent(tap, steiner, 0);
+        tap = steiner;
+    }
+    add_node(at, tap, best.wire, NodeKind::Sink);
+}
+
+void EcoEditor::changed_segments(vector<LineSegment>& removed, vector<LineSegment>& added) const {
+    vector<LineSegment> old_wire = before, new_wire;
+    LineSegment segments[3];
+    for (int node : touched_nodes) {
+        int count = tree.edge_segments(node, segments);
+        new_wire.insert(new_wire.end(), segments, segments + count);
+    }
+
+    // The output holds merged runs, so a changed piece can lengthen or split
+    // a run shared with untouched wire. Runs only ever span one track, so
+    // the untouched wire on the tracks of changed pieces is enough to rebuild
+    // every affected run before and after.
+    vector<int> rows, columns;
+    auto add_track = [&](const LineSegment& s) {
+        if (s.start.y == s.end.y) rows.push_back(s.start.y);
+        else columns.push_back(s.start.x);
+    };
+    for (const LineSegment& s : old_wire) add_track(s);
+    for (const LineSegment& s : new_wire) add_track(s);
+    for (vector<int>* tracks : {&rows, &columns}) {
+        sort(tracks->begin(), tracks->end());
+        tracks->erase(unique(tracks->begin(), tracks->end()), tracks->end());
+    }
+    for (int i = 0; i < tree.size(); ++i) {
+        if (touched[i]) continue;
+        int count = tree.edge_segments(i, segments);
+        for (int k = 0; k < count; ++k) {
+            const LineSegment& s = segments[k];
+            bool affected = s.start.y == s.end.y
+                                ? binary_search(rows.begin(), rows.end(), s.start.y)
+                                : binary_search(columns.begin(), columns.end(), s.start.x);
+            if (!affected) continue;
+            old_wire.push_back(s);
+            new_wire.push_back(s);
+        }
+    }
+
+    old_wire = merge_collinear(old_wire);
+    new_wire = merge_collinear(new_wire);
+    sort(old_wire.begin(), old_wire.end());
+    sort(new_wire.begin(), new_wire.end());
+    removed.clear();
+    added.clear();
+    set_difference(old_wire.begin(), old_wire.end(), new_wire.begin(), new_wire.end(),
+                   back_inserter(removed));
+    set_difference(new_wire.begin(), new_wire.end(), old_wire.begin(), old_wire.end(),
+                   back_inserter(added));
+}
+
+const TreeEvaluator& EcoEditor::evaluation() {
+    if (reshaped) {
+        evaluator.evaluate();
+        reshaped = false;
+        incremental = false;
+    }
+    assert(!incremental || matches_full_evaluation());
+    return evaluator;
+}
+
+bool EcoEditor::matches_full_evaluation() const {
+    TreeEvaluator full(tree, evaluator.rc_model());
+    full.evaluate();
+    auto close = [](double a, double b) { return fabs(a - b) <= 1e-9 * max(1.0, fabs(b)); };
+    for (int i = 0; i < tree.size(); ++i) {
+        if (tree.parent(i) < 0 && i != tree.get_root()) continue;
+        if (evaluator.path_length(i) != full.path_length(i)) return false;
+        if (!close(evaluator.elmore_delay(i), full.elmore_delay(i))) return false;
+    }
+    return evaluator.max_path() == full.max_path() && evaluator.min_path() == full.min_path() &&
+           close(evaluator.max_delay(), full.max_delay()) &&
+           close(evaluator.min_delay(), full.min_delay());
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "flat_tree.hpp"
+#include "geometry.hpp"
+#include "tree_eval.hpp"
+#include <string>
+#include <vector>
+
+enum class EcoAction { Add, Remove, Move };
+
+struct EcoChange {
+    EcoAction action;
+    Point at;   // Sink to add, remove or move
+    Point to;   // New position of a moved sink
+};
+
+// Delta list of placement changes, one per line, ended by ".e":
+//   .add X Y
+//   .remove X Y
+//   .move X Y NEW_X NEW_Y
+// Malformed input throws runtime_error naming the line.
+std::vector<EcoChange> read_eco_changes(const std::string& filename);
+
+// Applies sink changes to a synthesized tree without rebuilding it.
+//
+// A removed sink is detached together with the Steiner nodes left without
+// children. An added sink hangs from the node that reaches it with the
+// least wire while it stays within two windows of the tree as loaded: its
+// path between the shortest and the longest source-to-sink path, and its
+// Elmore delay between the least and the greatest sink delay. The wire
+// snakes up to both lower bounds when needed. Path length alone is not
+// enough: a snake off a node near the source matches the path of the
+// other sinks but, loaded only by the new sink, arrives far earlier than
+// them. When no node fits, the one overshooting the windows least, relative
+// to their upper bounds, is used. A sink tap is first split into a Steiner
+// tap at the same spot, so sinks stay leaves.
+//
+// A moved leaf sink keeps its parent when the new spot can be reached
+// within the same windows: only its own wire is re-embedded, and while the
+// topology is unchanged the evaluator takes the change incrementally.
+// Otherwise a move is a removal and an addition.
+//
+// Only that one wire is re-embedded; the merge segments on the path to the
+// root are not, so nothing above a change moves and existing paths never
+// change. The load a new wire adds to its ancestors is left out of the tap
+// choice; the final evaluation includes it.
+//
+// Nodes are bucketed on a grid of about four per cell, so finding a sink
+// looks at one cell and the tap search walks rings of cells outwards until
+// no closer node can need less wire. Only a sink no node can fit scans
+// every cell. That suits small ECOs; large ones should resynthesize.
+class EcoEditor {
+public:
+    explicit EcoEditor(FlatTree& tree, RcModel model = RcModel());
+
+    // Throws runtime_error when there is no sink to remove or move
+    void apply(const EcoChange& change);
+
+    // Wire runs of the output file (merged collinear, pointing right or up)
+    // present before the first change and gone now, and the ones present now
+    // that were not before; unchanged runs cancel out
+    void changed_segments(std::vector<LineSegment>& removed, std::vector<LineSegment>& added) const;
+
+    // Path lengths and Elmore delays now. In-place moves were applied to
+    // it incrementally; after an addition or removal it is evaluated again.
+    // Unless built with NDEBUG (make debug), incremental results are
+    // asserted to match a full evaluation of the edited tree.
+    const TreeEvaluator& evaluation();
+
+private:
+    // Wire from a node to a new sink and the sink's resulting arrival
+    struct Tap {
+        long long wire = 0;
+        double delay = 0;       // Estimated Elmore delay at the sink
+        double excess = 0;      // Overshoot of both windows relative to
+                                // their upper bounds; 0 when the sink fits
+    };
+
+    FlatTree& tree;
+    TreeEvaluator evaluator;
+    bool reshaped = false;              // Topology changed since evaluated
+    bool incremental = false;           // update_subtree() ran since evaluated
+    std::vector<long long> latency;     // Source-to-node path length
+    std::vector<double> delay;          // Source-to-node Elmore delay, leaving
+                                        // out load the ECO changed above
+    long long earliest = 0;             // Shortest sink path when loaded
+    long long latest = 0;               // Longest sink path when loaded
+    double fastest = 0;                 // Least sink delay when loaded
+    double slowest = 0;                 // Greatest sink delay when loaded
+    std::vector<char> touched;          // Node has an entry in `before`
+    std::vector<int> touched_nodes;
+    std::vector<LineSegment> before;    // Original wire of touched nodes
+
+    // Node grid; points outside the loaded bounding box go to edge cells
+    Point origin;
+    int cell_size = 1;
+    int columns = 1, rows = 1;
+    std::vector<std::vector<int>> cells;
+
+    // Record the wire of an existing node before it changes
+    void touch(int node);
+    int add_node(const Point& at, int parent, long long wire, NodeKind kind);
+    bool attached(int node) const { return tree.parent(node) >= 0 || node == tree.get_root(); }
+    bool matches_full_evaluation() const;
+    double wire_delay(long long wire) const;
+    Tap tap_from(int node, const Point& at) const;
+    void build_grid();
+    int cell_column(int x) const;
+    int cell_row(int y) const;
+    void index(int node);
+    void unindex(int node);
+    int find_sink(const Point& at) const;
+    bool move_sink(int node, const Point& to);
+    void remove_sink(int node);
+    void add_sink(const Point& at);
+};
@@ -0,0 +1,149 @@
+#include "flat_tree.hpp"
+#include <algorithm>
+#include <cstring>
+using namespace std;
+
+void FlatTree::clear() {
+    arena.reset();
+    count = capacity = 0;
+    root = -1;
+    xs = ys = parents = first_children = next_siblings = wires = nullptr;
+    kinds = nullptr;
+}
+
+void FlatTree::reserve(int wanted) {
+    if (wanted <= capacity) return;
+
+    // Old arrays stay in the arena until clear(); growing geometrically
+    // bounds that waste by the final size
+    auto grow = [&](auto*& array) {
+        using T = remove_reference_t<decltype(*array)>;
+        T* fresh = arena.allocate<T>(wanted);
+        if (count > 0) memcpy(fresh, array, count * sizeof(T));
+        array = fresh;
+    };
+    grow(xs);
+    grow(ys);
+    grow(parents);
+    grow(first_children);
+    grow(next_siblings);
+    grow(wires);
+    grow(kinds);
+    capacity = wanted;
+}
+
+int FlatTree::add_node(int x, int y, int parent, int wire, NodeKind kind) {
+    if (count == capacity) reserve(max(1024, capacity * 2));
+
+    int i = count++;
+    xs[i] = x;
+    ys[i] = y;
+    parents[i] = parent;
+    wires[i] = parent < 0 ? 0 : wire;
+    kinds[i] = kind;
+    first_children[i] = -1;
+    next_siblings[i] = -1;
+
+    if (parent < 0) {
+        root = i;
+    } else {
+        next_siblings[i] = first_children[parent];
+        first_children[parent] = i;
+    }
+    return i;
+}
+
+void FlatTree::reroot(int node) {
+    if (node < 0 || node == root) return;
+
+    // Walk up flipping each edge; the wire moves with the edge
+    int prev = -1, prev_wire = 0;
+    for (int cur = node; cur >= 0;) {
+        int up = parents[cur], up_wire = wires[cur];
+        parents[cur] = prev;
+        wires[cur] = prev_wire;
+        prev = cur;
+        prev_wire = up_wire;
+        cur = up;
+    }
+    root = node;
+    link_children();
+}
+
+void FlatTree::set_parent(int i, int parent, int length) {
+    int old = parents[i];
+    if (old >= 0) {
+        int* link = &first_children[old];
+        while (*link != i) link = &next_siblings[*link];
+        *link = next_siblings[i];
+    }
+    parents[i] = parent;
+    wires[i] = parent < 0 ? 0 : length;
+    next_siblings[i] = -1;
+    if (parent >= 0) {
+        next_siblings[i] = first_children[parent];
+        first_children[parent] = i;
+    }
+}
+
+void FlatTree::link_children() {
+    fill(first_children, first_children + count, -1);
+    for (int i = 0; i < count; ++i) {
+        next_siblings[i] = -1;
+        if (parents[i] < 0) continue;
+        next_siblings[i] = first_children[parents[i]];
+        first_children[parents[i]] = i;
+    }
+}
+
+int FlatTree::edge_segments(int i, LineSegment* out) const {
+    int p = parents[i];
+    if (p < 0) return 0;
+
+    Point from(xs[p], ys[p]), to(xs[i], ys[i]);
+    int n = 0;
+    auto manhattan_path = [&](const Point& a, const Point& b) {
+        if (a.x != b.x) out[n++] = LineSegment(a, Point(b.x, a.y));
+        if (a.y != b.y) out[n++] = LineSegment(Point(b.x, a.y), b);
+    };
+
+    // The part beyond the Manhattan distance becomes a U-shaped detour just
+    // outside the span of the two ends, on whichever side still fits the die
+    int half = (wires[i] - manhattan_distance(from, to)) / 2;
+    if (half <= 0 || from == to) {
+        manhattan_path(from, to);
+        return n;
+    }
+
+    // A detour across y needs a horizontal run to turn around on
+    bool detour_y = from.x != to.x;
+    int lo = detour_y ? min(from.y, to.y) : min(from.x, to.x);
+    int hi = detour_y ? max(from.y, to.y) : max(from.x, to.x);
+    int limit = detour_y ? dimY : dimX;
+    int room_hi = limit - hi, room_lo = lo;
+    int pivot = (room_hi >= half || room_hi >= room_lo) ? hi + min(half, room_hi)
+                                                         : lo - min(half, room_lo);
+
+    if (detour_y) {
+        manhattan_path(from, Point(from.x, pivot));
+        manhattan_path(Point(from.x, pivot), Point(to.x, pivot));
+        manhattan_path(Point(to.x, pivot), to);
+    } else {
+        manhattan_path(from, Point(pivot, from.y));
+        manhattan_path(Point(pivot, from.y), Point(pivot, to.y));
+        manhattan_path(Point(pivot, to.y), to);
+    }
+    return n;
+}
+
+long long FlatTree::total_wire() const {
+    // Summed over the routed segments so a detour clipped by the die
+    // boundary is not over-counted
+    LineSegment buffer[3];
+    long long total = 0;
+    for (int i = 0; i < count; ++i) {
+        int n = edge_segments(i, buffer);
+        for (int k = 0; k < n; ++k) total += manhattan_distance(buffer[k].start, buffer[k].end);
+    }
+    return total;
+}
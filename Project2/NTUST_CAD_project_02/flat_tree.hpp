@@ -0,0 +1,66 @@
+#pragma once
+#include "arena.hpp"
+#include "geometry.hpp"
+#include <cstdint>
+
+enum class NodeKind : std::uint8_t { Source, Sink, Steiner };
+
+// Clock tree stored as structure-of-arrays in an arena. Node i hangs below
+// parent(i) through a wire of length wire(i); the wire runs horizontally
+// first and snakes when wire(i) exceeds the Manhattan distance. Children form
+// an intrusive list through first_child / next_sibling.
+class FlatTree {
+public:
+    void clear();
+    void reserve(int count);
+    void set_die(int dimX, int dimY) { this->dimX = dimX; this->dimY = dimY; }
+    int die_x() const { return dimX; }
+    int die_y() const { return dimY; }
+
+    // Append a node; parent -1 makes it the root
+    int add_node(int x, int y, int parent, int wire, NodeKind kind);
+
+    // Turn the tree around so `node` becomes the root
+    void reroot(int node);
+
+    int size() const { return count; }
+    int get_root() const { return root; }
+    int x(int i) const { return xs[i]; }
+    int y(int i) const { return ys[i]; }
+    Point point(int i) const { return Point(xs[i], ys[i]); }
+    int parent(int i) const { return parents[i]; }
+    int first_child(int i) const { return first_children[i]; }
+    int next_sibling(int i) const { return next_siblings[i]; }
+    int wire(int i) const { return wires[i]; }
+    NodeKind kind(int i) const { return kinds[i]; }
+
+    void set_point(int i, const Point& p) { xs[i] = p.x; ys[i] = p.y; }
+    void set_wire(int i, int length) { wires[i] = length; }
+    void set_kind(int i, NodeKind kind) { kinds[i] = kind; }
+
+    // Move node i with its subtree below `parent` through a wire of `length`.
+    // Parent -1 detaches it: the node keeps its index but is no longer
+    // reached from the root and routes no wire.
+    void set_parent(int i, int parent, int length);
+
+    // Rectilinear segments realising the wire above node i (at most 3)
+    int edge_segments(int i, LineSegment* out) const;
+
+    long long total_wire() const;
+    // Arena bytes held, including arrays outgrown since clear()
+    std::size_t memory_bytes() const { return arena.bytes_reserved(); }
+
+private:
+    Arena arena;
+    int count = 0, capacity = 0, root = -1;
+    int dimX = 0, dimY = 0;
+    int* xs = nullptr;
+    int* ys = nullptr;
+    int* parents = nullptr;
+    int* first_children = nullptr;
+    int* next_siblings = nullptr;
+    int* wires = nullptr;
+    NodeKind* kinds = nullptr;
+
+    void link_children();
+};
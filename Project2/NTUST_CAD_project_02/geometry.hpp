@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdlib>
+
+struct Point {
+    int x, y;
+    Point(int x = 0, int y = 0) : x(x), y(y) {}
+    bool operator==(const Point& other) const {
+        return x == other.x && y == other.y;
+    }
+    bool operator<(const Point& other) const {
+        if (x != other.x) return x < other.x;
+        return y < other.y;
+    }
+    bool operator!=(const Point& other) const {
+        return !(*this == other);
+    }
+};
+
+struct LineSegment {
+    Point start, end;
+    LineSegment(Point s = Point(), Point e = Point()) : start(s), end(e) {}
+    bool operator<(const LineSegment& other) const {
+        if (start != other.start) return start < other.start;
+        return end < other.end;
+    }
+};
+
+inline int manhattan_distance(const Point& a, const Point& b) {
+    return std::abs(a.x - b.x) + std::abs(a.y - b.y);
+}
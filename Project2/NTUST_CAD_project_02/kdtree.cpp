@@ -0,0 +1,101 @@
+#include "kdtree.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+using namespace std;
+
+void KdTree::build(vector<Item> points) {
+    items = move(points);
+    const int n = items.size();
+    axis.assign(n, 0);
+    alive.assign(n, 0);
+    removed.assign(n, 0);
+
+    int max_id = -1;
+    for (const auto& item : items) max_id = max(max_id, item.id);
+    slot.assign(max_id + 1, -1);
+
+    build_range(0, n);
+    for (int i = 0; i < n; ++i) slot[items[i].id] = i;
+    live = n;
+}
+
+void KdTree::build_range(int lo, int hi) {
+    if (lo >= hi) return;
+
+    // Split the axis with the widest spread
+    double lo_c[3], hi_c[3];
+    for (int k = 0; k < 3; ++k) {
+        lo_c[k] = numeric_limits<double>::max();
+        hi_c[k] = numeric_limits<double>::lowest();
+    }
+    for (int i = lo; i < hi; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            lo_c[k] = min(lo_c[k], items[i].c[k]);
+            hi_c[k] = max(hi_c[k], items[i].c[k]);
+        }
+    }
+    int k = 0;
+    for (int j = 1; j < 3; ++j) {
+        if (hi_c[j] - lo_c[j] > hi_c[k] - lo_c[k]) k = j;
+    }
+
+    int mid = (lo + hi) / 2;
+    nth_element(items.begin() + lo, items.begin() + mid, items.begin() + hi,
+                [k](const Item& a, const Item& b) { return a.c[k] < b.c[k]; });
+    axis[mid] = k;
+    alive[mid] = hi - lo;
+
+    build_range(lo, mid);
+    build_range(mid + 1, hi);
+}
+
+void KdTree::erase(int id) {
+    if (id < 0 || id >= static_cast<int>(slot.size()) || slot[id] < 0) return;
+    int pos = slot[id];
+    slot[id] = -1;
+
+    int lo = 0, hi = items.size();
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        --alive[mid];
+        if (pos == mid) break;
+        if (pos < mid) hi = mid;
+        else lo = mid + 1;
+    }
+    removed[pos] = 1;
+    --live;
+}
+
+int KdTree::nearest(const double* query, int exclude, double& best_dist) const {
+    int best = -1;
+    best_dist = numeric_limits<double>::max();
+    search(0, items.size(), query, exclude, best, best_dist);
+    return best;
+}
+
+void KdTree::search(int lo, int hi, const double* query, int exclude,
+                    int& best, double& best_dist) const {
+    if (lo >= hi) return;
+    int mid = (lo + hi) / 2;
+    if (alive[mid] == 0) return;
+
+    const Item& pivot = items[mid];
+    if (!removed[mid] && pivot.id != exclude) {
+        double d = max({fabs(pivot.c[0] - query[0]), fabs(pivot.c[1] - query[1]),
+                        fabs(pivot.c[2] - query[2])});
+        if (d < best_dist) {
+            best_dist = d;
+            best = pivot.id;
+        }
+    }
+
+    double delta = query[axis[mid]] - pivot.c[axis[mid]];
+    if (delta < 0) {
+        search(lo, mid, query, exclude, best, best_dist);
+        if (-delta < best_dist) search(mid + 1, hi, query, exclude, best, best_dist);
+    } else {
+        search(mid + 1, hi, query, exclude, best, best_dist);
+        if (delta < best_dist) search(lo, mid, query, exclude, best, best_dist);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+
+// Static 3-d tree with lazy deletion for nearest-neighbour queries under the
+// Chebyshev (L-infinity) metric. Built once per matching round in
+// O(n log n); erase() and nearest() are O(log n) expected.
+//
+// There is no insert: merged subtrees enter the next round's rebuild. A
+// round matches nearly every live subtree, so with inserts the erased items
+// would outnumber the live ones after every round and a rebuild would be
+// due anyway. The live count halves each round, so all rebuilds together
+// cost O(n log n).
+//
+// The tree is implicit: every range [lo, hi) of `items` has its splitting
+// item at mid = (lo + hi) / 2, so no node objects are allocated.
+class KdTree {
+public:
+    struct Item {
+        double c[3];
+        int id;     // Caller's handle, returned by nearest()
+    };
+
+    void build(std::vector<Item> points);
+
+    // Remove an item by the id it was built with
+    void erase(int id);
+
+    // Closest live item to `query` other than `exclude`; -1 if none is left
+    int nearest(const double* query, int exclude, double& best_dist) const;
+
+    int size() const { return live; }
+
+    // Items in tree order; querying in this order keeps the walk cache-local
+    const std::vector<Item>& get_items() const { return items; }
+
+private:
+    std::vector<Item> items;
+    std::vector<unsigned char> axis; // Splitting axis of the range at each mid
+    std::vector<int> alive;          // Live items in the range at each mid
+    std::vector<char> removed;       // Erased flag per position
+    std::vector<int> slot;           // id -> position in items, -1 if absent
+    int live = 0;
+
+    void build_range(int lo, int hi);
+    void search(int lo, int hi, const double* query, int exclude,
+                int& best, double& best_dist) const;
+};
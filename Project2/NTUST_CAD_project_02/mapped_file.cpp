@@ -0,0 +1,40 @@
+#include "mapped_file.hpp"
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+MappedFile::MappedFile(const string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("Cannot open file: " + filename);
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED) {
+            madvise(view, info.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(view);
+            length = info.st_size;
+            mapped = true;
+        }
+    }
+
+    if (!mapped) {
+        char chunk[1 << 16];
+        ssize_t got;
+        while ((got = read(fd, chunk, sizeof(chunk))) > 0) buffer.append(chunk, got);
+        if (got < 0) {
+            close(fd);
+            throw runtime_error("Cannot read file: " + filename);
+        }
+        data = buffer.data();
+        length = buffer.size();
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (mapped) munmap(const_cast<char*>(data), length);
+}
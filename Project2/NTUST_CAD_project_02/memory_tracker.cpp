@@ -0,0 +1,91 @@
+#include "memory_tracker.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <malloc.h>
+#include <new>
+
+namespace {
+
+std::atomic<bool> tracking{false};
+thread_local HeapTracker::Account own;
+thread_local HeapTracker::Account* charged = nullptr;  // Null for `own`
+
+HeapTracker::Account& current_account() { return charged ? *charged : own; }
+
+void* tracked_alloc(std::size_t size) {
+    void* block = std::malloc(size ? size : 1);
+    if (!block) throw std::bad_alloc();
+    if (tracking.load(std::memory_order_relaxed)) {
+        HeapTracker::Account& account = current_account();
+        long long bytes = malloc_usable_size(block);
+        long long live = account.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        long long peak = account.peak.load(std::memory_order_relaxed);
+        while (live > peak &&
+               !account.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+    }
+    return block;
+}
+
+void tracked_free(void* block) {
+    if (!block) return;
+    if (tracking.load(std::memory_order_relaxed)) {
+        current_account().live.fetch_sub(malloc_usable_size(block), std::memory_order_relaxed);
+    }
+    std::free(block);
+}
+
+// A "Vm...:   123 kB" line of /proc/self/status
+long long status_kb(const char* field) {
+    std::FILE* status = std::fopen("/proc/self/status", "r");
+    if (!status) return 0;
+    char line[256];
+    long long kb = 0;
+    std::size_t length = std::strlen(field);
+    while (std::fgets(line, sizeof(line), status)) {
+        if (std::strncmp(line, field, length) == 0 && line[length] == ':') {
+            kb = std::atoll(line + length + 1);
+            break;
+        }
+    }
+    std::fclose(status);
+    return kb;
+}
+
+}  // namespace
+
+void HeapTracker::enable() { tracking.store(true, std::memory_order_relaxed); }
+HeapTracker::Account& HeapTracker::current() { return current_account(); }
+
+HeapTracker::Scope::Scope(Account& account) : outer(charged) { charged = &account; }
+HeapTracker::Scope::~Scope() { charged = outer; }
+
+long long RssTracker::peak_bytes() { return status_kb("VmHWM") * 1024; }
+
+bool RssTracker::reset_peak() {
+    std::FILE* refs = std::fopen("/proc/self/clear_refs", "w");
+    if (!refs) return false;
+    bool done = std::fputs("5", refs) >= 0;
+    return std::fclose(refs) == 0 && done;
+}
+
+void* operator new(std::size_t size) { return tracked_alloc(size); }
+void* operator new[](std::size_t size) { return tracked_alloc(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return tracked_alloc(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return operator new(size, std::nothrow);
+}
+void operator delete(void* block) noexcept { tracked_free(block); }
+void operator delete[](void* block) noexcept { tracked_free(block); }
+void operator delete(void* block, std::size_t) noexcept { tracked_free(block); }
+void operator delete[](void* block, std::size_t) noexcept { tracked_free(block); }
+void operator delete(void* block, const std::nothrow_t&) noexcept { tracked_free(block); }
+void operator delete[](void* block, const std::nothrow_t&) noexcept { tracked_free(block); }
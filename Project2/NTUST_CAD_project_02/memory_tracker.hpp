@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+
+// Heap usage charged to accounts. The global operator new and delete are
+// replaced to add the live bytes of every block to the calling thread's
+// current account and keep that account's peak. A thread starts on an
+// account of its own; a Scope moves it to a shared one, and TaskPool runs
+// each task on the account of the thread that spawned it, so a run's peak
+// adds up the heap of all its workers and concurrent batch cases each get
+// their own. A block freed on another account than the one it was
+// allocated on counts against the freeing one.
+//
+// Counting is off until enable() is called, and then costs every allocation
+// a malloc_usable_size() call and two relaxed atomics; until then the hooks
+// check one relaxed atomic flag and go straight to malloc/free. Only batch
+// and benchmark runs, which report the peak, turn it on. A block allocated
+// before enable() and freed after it lowers the freeing account.
+class HeapTracker {
+public:
+    struct Account {
+        std::atomic<long long> live{0};
+        std::atomic<long long> peak{0};
+    };
+
+    // Charges the calling thread's allocations to `account` while alive
+    class Scope {
+    public:
+        explicit Scope(Account& account);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Account* outer;
+    };
+
+    static void enable();
+
+    // Account the calling thread is charging now
+    static Account& current();
+};
+
+// Peak resident set size of the whole process, read from /proc/self/status.
+// reset_peak() restarts the high-water mark through /proc/self/clear_refs
+// and returns false where the kernel does not allow it; the peak then
+// covers the life of the process. The peak reads 0 without /proc.
+class RssTracker {
+public:
+    static long long peak_bytes();
+    static bool reset_peak();
+};
@@ -0,0 +1,171 @@
+#include "quadrant_kernels.hpp"
+#include <cstring>
+
+#if !defined(CTS_NO_SIMD) && defined(__GNUC__) && defined(__x86_64__)
+#define CTS_AVX2 1
+#include <immintrin.h>
+#endif
+using namespace std;
+
+namespace {
+
+inline int quadrant_code(int x, int y, const Point& center) {
+    return (x > center.x) | (y > center.y) << 1;
+}
+
+void sum_scalar(const int* x, const int* y, int n, long long& sum_x, long long& sum_y) {
+    for (int i = 0; i < n; ++i) {
+        sum_x += x[i];
+        sum_y += y[i];
+    }
+}
+
+void count_scalar(const int* x, const int* y, int n, const Point& center, array<int, 4>& counts) {
+    for (int i = 0; i < n; ++i) ++counts[quadrant_code(x[i], y[i], center)];
+}
+
+// Branch-free: the destination is picked by index, not by an if chain
+void scatter_scalar(const int* x, const int* y, const int* id, int n, const Point& center,
+                    array<int, 4>& at, int* to_x, int* to_y, int* to_id) {
+    for (int i = 0; i < n; ++i) {
+        int k = at[quadrant_code(x[i], y[i], center)]++;
+        to_x[k] = x[i];
+        to_y[k] = y[i];
+        to_id[k] = id[i];
+    }
+}
+
+#ifdef CTS_AVX2
+const bool use_avx2 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+}();
+
+// Eight lanes widened to 64 bits and added to four 64-bit accumulators
+__attribute__((target("avx2"))) inline __m256i add_widened(__m256i sum, __m256i v) {
+    sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+    return _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+}
+
+__attribute__((target("avx2"))) long long horizontal_sum(__m256i v) {
+    alignas(32) long long lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// Bit k of `right`/`above` tells where pin i + k lies
+__attribute__((target("avx2"))) inline void side_masks(const int* x, const int* y, int i,
+                                                        __m256i cx, __m256i cy,
+                                                        unsigned& right, unsigned& above) {
+    __m256i vx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+    __m256i vy = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+    right = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(vx, cx)));
+    above = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(vy, cy)));
+}
+
+__attribute__((target("avx2"))) int sum_avx2(const int* x, const int* y, int n,
+                                             long long& sum_x, long long& sum_y) {
+    __m256i ax = _mm256_setzero_si256(), ay = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        ax = add_widened(ax, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)));
+        ay = add_widened(ay, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i)));
+    }
+    sum_x += horizontal_sum(ax);
+    sum_y += horizontal_sum(ay);
+    return i;
+}
+
+__attribute__((target("avx2"))) int count_avx2(const int* x, const int* y, int n,
+                                               const Point& center, array<int, 4>& counts) {
+    const __m256i cx = _mm256_set1_epi32(center.x), cy = _mm256_set1_epi32(center.y);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        unsigned right, above;
+        side_masks(x, y, i, cx, cy, right, above);
+        int q1 = __builtin_popcount(right & ~above);
+        int q2 = __builtin_popcount(~right & above & 0xff);
+        int q3 = __builtin_popcount(right & above);
+        counts[0] += 8 - q1 - q2 - q3;
+        counts[1] += q1;
+        counts[2] += q2;
+        counts[3] += q3;
+    }
+    return i;
+}
+
+// Classifies eight pins per compare; the stores stay scalar since AVX2 has
+// no scatter, and they are sequential within each quadrant anyway
+__attribute__((target("avx2"))) int scatter_avx2(const int* x, const int* y, const int* id, int n,
+                                                 const Point& center, array<int, 4>& at,
+                                                 int* to_x, int* to_y, int* to_id) {
+    const __m256i cx = _mm256_set1_epi32(center.x), cy = _mm256_set1_epi32(center.y);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        unsigned right, above;
+        side_masks(x, y, i, cx, cy, right, above);
+        for (int k = 0; k < 8; ++k) {
+            int q = (right >> k & 1) | (above >> k & 1) << 1;
+            int to = at[q]++;
+            to_x[to] = x[i + k];
+            to_y[to] = y[i + k];
+            to_id[to] = id[i + k];
+        }
+    }
+    return i;
+}
+#endif
+
+}  // namespace
+
+Point centroid(const int* x, const int* y, int n) {
+    long long sum_x = 0, sum_y = 0;
+    int done = 0;
+#ifdef CTS_AVX2
+    if (use_avx2) done = sum_avx2(x, y, n, sum_x, sum_y);
+#endif
+    sum_scalar(x + done, y + done, n - done, sum_x, sum_y);
+    return Point(static_cast<int>(sum_x / n), static_cast<int>(sum_y / n));
+}
+
+array<int, 4> count_quadrants(const int* x, const int* y, int n, const Point& center) {
+    array<int, 4> counts{};
+    int done = 0;
+#ifdef CTS_AVX2
+    if (use_avx2) done = count_avx2(x, y, n, center, counts);
+#endif
+    count_scalar(x + done, y + done, n - done, center, counts);
+    return counts;
+}
+
+void scatter_quadrants(const int* x, const int* y, const int* id, int n, const Point& center,
+                       array<int, 4> at, int* to_x, int* to_y, int* to_id) {
+    int done = 0;
+#ifdef CTS_AVX2
+    if (use_avx2) done = scatter_avx2(x, y, id, n, center, at, to_x, to_y, to_id);
+#endif
+    scatter_scalar(x + done, y + done, id + done, n - done, center, at, to_x, to_y, to_id);
+}
+
+array<int, 4> partition_quadrants(int* x, int* y, int* id, int n, const Point& center,
+                                  int* scratch_x, int* scratch_y, int* scratch_id) {
+    array<int, 4> counts = count_quadrants(x, y, n, center);
+    // Already split when all pins share a quadrant
+    for (int q = 0; q < 4; ++q) {
+        if (counts[q] == n) return counts;
+    }
+    array<int, 4> at = {0, counts[0], counts[0] + counts[1], counts[0] + counts[1] + counts[2]};
+    scatter_quadrants(x, y, id, n, center, at, scratch_x, scratch_y, scratch_id);
+    memcpy(x, scratch_x, n * sizeof(int));
+    memcpy(y, scratch_y, n * sizeof(int));
+    memcpy(id, scratch_id, n * sizeof(int));
+    return counts;
+}
+
+bool simd_kernels_enabled() {
+#ifdef CTS_AVX2
+    return use_avx2;
+#else
+    return false;
+#endif
+}
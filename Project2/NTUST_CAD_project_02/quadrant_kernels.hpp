@@ -0,0 +1,44 @@
+#pragma once
+#include "geometry.hpp"
+#include <array>
+#include <vector>
+
+// Pins of the quadrant build as parallel arrays (structure of arrays), so
+// the kernels below stream plain int columns
+struct PinArrays {
+    std::vector<int> x, y, id;
+
+    void resize(int n) {
+        x.resize(n);
+        y.resize(n);
+        id.resize(n);
+    }
+};
+
+// Inner loops of the quadrant build over x[]/y[]/id[] columns. Coordinate
+// sums are kept in 64 bits, so large dies with many pins cannot overflow.
+// On x86-64 CPUs with AVX2 the loops handle eight pins per step, chosen at
+// run time; elsewhere, for the tails, or when built with -DCTS_NO_SIMD, the
+// scalar code gives the same results.
+//
+// Quadrants are numbered as in the serial build: bit 0 is set right of
+// `center` (x > center.x) and bit 1 above it (y > center.y).
+
+// Integer mean of n > 0 pins, truncated like the former int division
+Point centroid(const int* x, const int* y, int n);
+
+// Pins per quadrant
+std::array<int, 4> count_quadrants(const int* x, const int* y, int n, const Point& center);
+
+// Copies every pin to to_*[at[q]++] of its quadrant q, in input order
+void scatter_quadrants(const int* x, const int* y, const int* id, int n, const Point& center,
+                       std::array<int, 4> at, int* to_x, int* to_y, int* to_id);
+
+// Stable 4-way partition in place, through `scratch` columns of at least n
+// entries: quadrant 0 first, each quadrant in input order. Returns the
+// quadrant sizes.
+std::array<int, 4> partition_quadrants(int* x, int* y, int* id, int n, const Point& center,
+                                       int* scratch_x, int* scratch_y, int* scratch_id);
+
+// Whether the AVX2 kernels are in use on this machine
+bool simd_kernels_enabled();
@@ -0,0 +1,394 @@
+#include "rsmt.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+using namespace std;
+
+namespace {
+
+// POWVs of every four-pin position sequence, indexed by the Lehmer code of
+// the y ranks taken in x order. A vector is (h0, h1, h2, v0, v1, v2): how
+// often each gap between consecutive x (resp. y) coordinates is covered.
+// Generated by exhaustive enumeration of Steiner trees on the Hanan grid.
+struct Powv {
+    int count;
+    unsigned char w[2][6];
+};
+
+const Powv powv4[24] = {
+    {1, {{1, 1, 1, 1, 1, 1}}},                      // (0,1,2,3)
+    {1, {{1, 1, 1, 1, 1, 1}}},                      // (0,1,3,2)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (0,2,1,3)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (0,2,3,1)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (0,3,1,2)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (0,3,2,1)
+    {1, {{1, 1, 1, 1, 1, 1}}},                      // (1,0,2,3)
+    {1, {{1, 1, 1, 1, 1, 1}}},                      // (1,0,3,2)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (1,2,0,3)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (1,2,3,0)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (1,3,0,2)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (1,3,2,0)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (2,0,1,3)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (2,0,3,1)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (2,1,0,3)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (2,1,3,0)
+    {1, {{1, 1, 1, 1, 1, 1}}},                      // (2,3,0,1)
+    {1, {{1, 1, 1, 1, 1, 1}}},                      // (2,3,1,0)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (3,0,1,2)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (3,0,2,1)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (3,1,0,2)
+    {2, {{1, 1, 1, 1, 2, 1}, {1, 2, 1, 1, 1, 1}}},  // (3,1,2,0)
+    {1, {{1, 1, 1, 1, 1, 1}}},                      // (3,2,0,1)
+    {1, {{1, 1, 1, 1, 1, 1}}},                      // (3,2,1,0)
+};
+
+int bit_width(uint64_t value) {
+    int bits = 0;
+    while (bits < 64 && value >> bits) ++bits;
+    return bits;
+}
+
+// LSD radix sort, a byte per pass, over only the bits any key uses; the
+// sorts here are all of packed integer keys
+void radix_sort(vector<uint64_t>& keys) {
+    uint64_t used = 0;
+    for (uint64_t k : keys) used |= k;
+    vector<uint64_t> buffer(keys.size());
+    for (int shift = 0, bits = bit_width(used); shift < bits; shift += 8) {
+        size_t count[257] = {};
+        for (uint64_t k : keys) ++count[(k >> shift & 255) + 1];
+        partial_sum(count, count + 257, count);
+        for (uint64_t k : keys) buffer[count[k >> shift & 255]++] = k;
+        keys.swap(buffer);
+    }
+}
+
+// Sorts points by (x, y), or by (y, x) when `y_first`: both coordinates,
+// offset to their minimum, are packed into one key and radix sorted
+void sort_points(Point* first, Point* last, bool y_first) {
+    const size_t n = last - first;
+    if (n < 2) return;
+    auto major = [&](const Point& p) { return y_first ? p.y : p.x; };
+    auto minor = [&](const Point& p) { return y_first ? p.x : p.y; };
+    int major_lo = major(*first), minor_lo = minor(*first), minor_hi = minor_lo;
+    for (const Point* p = first; p != last; ++p) {
+        major_lo = min(major_lo, major(*p));
+        minor_lo = min(minor_lo, minor(*p));
+        minor_hi = max(minor_hi, minor(*p));
+    }
+    const int shift = bit_width(uint64_t(int64_t(minor_hi) - minor_lo));
+    vector<uint64_t> keys(n);
+    for (size_t k = 0; k < n; ++k) {
+        keys[k] = uint64_t(int64_t(major(first[k])) - major_lo) << shift |
+                  uint64_t(int64_t(minor(first[k])) - minor_lo);
+    }
+    radix_sort(keys);
+    const uint64_t mask = (uint64_t(1) << shift) - 1;
+    for (size_t k = 0; k < n; ++k) {
+        int a = int(int64_t(keys[k] >> shift) + major_lo);
+        int b = int(int64_t(keys[k] & mask) + minor_lo);
+        first[k] = y_first ? Point(b, a) : Point(a, b);
+    }
+}
+
+struct Edge {
+    int a, b;
+    long long len;
+};
+
+// Candidate edges of the rectilinear MST: for every pin, the nearest pin in
+// the octants dy >= dx >= 0 and dy >= -dx >= 0 of pins sorted by (x, y).
+// Pins are swept by decreasing x while a Fenwick tree over y - x ranks holds
+// the smallest x + y seen so far; the second octant is the same sweep on
+// (-x, y). Called again on the transposed pins this covers one octant of
+// every opposite pair, which is all Kruskal needs. `ids` maps positions
+// back to pin numbers.
+void octant_edges(const vector<Point>& pins, const vector<int>& ids, vector<Edge>& edges) {
+    const int n = pins.size();
+
+    // Sorts positions by a 33-bit value packed above the position
+    const int shift = bit_width(n);
+    const uint64_t mask = (uint64_t(1) << shift) - 1;
+    vector<uint64_t> packed(n);
+    vector<int> rank(n);
+    auto rank_by = [&](auto value) {
+        long long lo = value(0);
+        for (int i = 1; i < n; ++i) lo = min(lo, value(i));
+        for (int i = 0; i < n; ++i) packed[i] = uint64_t(value(i) - lo) << shift | i;
+        radix_sort(packed);
+
+        // Rank 1 for the largest value
+        for (int k = n - 1, r = 0; k >= 0; --k) {
+            if (k < n - 1 && packed[k] >> shift != packed[k + 1] >> shift) r = n - 1 - k;
+            rank[packed[k] & mask] = r + 1;
+        }
+    };
+
+    // Empty slots hold the largest sum so the min needs no special case
+    const long long empty = numeric_limits<long long>::max();
+    struct Slot {
+        long long sum;
+        int at;
+    };
+    vector<Slot> fenwick(n + 1);
+    auto sweep = [&](auto for_each_pin, auto sum_of) {
+        fill(fenwick.begin(), fenwick.end(), Slot{empty, -1});
+        for_each_pin([&](int i) {
+            long long sum = sum_of(i);
+            Slot best{empty, -1};
+            for (int k = rank[i]; k > 0; k -= k & -k) {
+                best = fenwick[k].sum < best.sum ? fenwick[k] : best;
+            }
+            if (best.at >= 0) edges.push_back({ids[i], ids[best.at], best.sum - sum});
+            for (int k = rank[i]; k <= n; k += k & -k) {
+                fenwick[k] = sum < fenwick[k].sum ? Slot{sum, i} : fenwick[k];
+            }
+        });
+    };
+
+    auto x_plus_y = [&](int i) { return static_cast<long long>(pins[i].x) + pins[i].y; };
+    auto y_minus_x = [&](int i) { return static_cast<long long>(pins[i].y) - pins[i].x; };
+
+    // (x, y): decreasing x, then decreasing y
+    rank_by(y_minus_x);
+    sweep([&](auto visit) {
+        for (int i = n - 1; i >= 0; --i) visit(i);
+    }, x_plus_y);
+
+    // (-x, y): increasing x, then decreasing y
+    rank_by(x_plus_y);
+    sweep([&](auto visit) {
+        for (int lo = 0, hi; lo < n; lo = hi) {
+            for (hi = lo; hi < n && pins[hi].x == pins[lo].x; ++hi) {}
+            for (int i = hi - 1; i >= lo; --i) visit(i);
+        }
+    }, y_minus_x);
+}
+
+int find_root(vector<int>& up, int v) {
+    while (up[v] != v) v = up[v] = up[up[v]];
+    return v;
+}
+
+}  // namespace
+
+long long RsmtEstimator::small_net(const Point* pins, int count) {
+    if (count <= 1) return 0;
+
+    int xmin = pins[0].x, xmax = pins[0].x, ymin = pins[0].y, ymax = pins[0].y;
+    for (int i = 1; i < count; ++i) {
+        xmin = min(xmin, pins[i].x);
+        xmax = max(xmax, pins[i].x);
+        ymin = min(ymin, pins[i].y);
+        ymax = max(ymax, pins[i].y);
+    }
+    long long hpwl = static_cast<long long>(xmax - xmin) + (ymax - ymin);
+    if (count <= 3) return hpwl;
+
+    // Ranks break ties by index, which keeps the table exact for
+    // coincident coordinates (the tied gap is simply zero)
+    int by_x[4] = {0, 1, 2, 3}, by_y[4] = {0, 1, 2, 3};
+    sort(by_x, by_x + 4, [&](int a, int b) {
+        return pins[a].x != pins[b].x ? pins[a].x < pins[b].x : a < b;
+    });
+    sort(by_y, by_y + 4, [&](int a, int b) {
+        return pins[a].y != pins[b].y ? pins[a].y < pins[b].y : a < b;
+    });
+    int y_rank[4];
+    for (int r = 0; r < 4; ++r) y_rank[by_y[r]] = r;
+
+    int code = 0;
+    for (int i = 0; i < 4; ++i) {
+        int smaller = 0;
+        for (int j = i + 1; j < 4; ++j) smaller += y_rank[by_x[j]] < y_rank[by_x[i]];
+        code = code * (4 - i) + smaller;
+    }
+
+    long long gaps[6];
+    for (int k = 0; k < 3; ++k) {
+        gaps[k] = static_cast<long long>(pins[by_x[k + 1]].x) - pins[by_x[k]].x;
+        gaps[3 + k] = static_cast<long long>(pins[by_y[k + 1]].y) - pins[by_y[k]].y;
+    }
+
+    const Powv& entry = powv4[code];
+    long long best = -1;
+    for (int v = 0; v < entry.count; ++v) {
+        long long length = 0;
+        for (int k = 0; k < 6; ++k) length += entry.w[v][k] * gaps[k];
+        if (best < 0 || length < best) best = length;
+    }
+    return best;
+}
+
+long long RsmtEstimator::wirelength(const vector<Point>& pins) {
+    const int n = pins.size();
+    if (n <= 4) return small_net(pins.data(), n);
+    vector<Point> sorted = pins;
+    if (n <= tile_pins) return tile_length(sorted);
+
+    // Break the net into tiles of about tile_pins pins: columns of equal pin
+    // count, each cut into blocks by y. A block also takes the top pin of
+    // the block below it, or the lowest pin of the previous column, so the
+    // tile trees join into one tree. Tiles that fit in cache are far faster
+    // than one global MST and lose only the few edges across tile borders.
+    sort_points(sorted.data(), sorted.data() + n, false);
+    int ymin = sorted[0].y, ymax = sorted[0].y;
+    for (const Point& p : sorted) {
+        ymin = min(ymin, p.y);
+        ymax = max(ymax, p.y);
+    }
+    double width = max(1.0, double(sorted.back().x) - sorted.front().x);
+    double height = max(1.0, double(ymax) - ymin);
+    int tiles = (n + tile_pins - 1) / tile_pins;
+    int columns = lround(sqrt(tiles * width / height));
+    columns = max(1, min(columns, tiles));
+
+    long long total = 0;
+    vector<Point> tile;
+    Point anchor;
+    for (int c = 0; c < columns; ++c) {
+        int lo = 1LL * n * c / columns, hi = 1LL * n * (c + 1) / columns;
+        sort_points(sorted.data() + lo, sorted.data() + hi, true);
+        int blocks = (hi - lo + tile_pins - 1) / tile_pins;
+        for (int r = 0; r < blocks; ++r) {
+            int a = lo + 1LL * (hi - lo) * r / blocks;
+            int b = lo + 1LL * (hi - lo) * (r + 1) / blocks;
+            tile.assign(sorted.begin() + a, sorted.begin() + b);
+            if (r > 0) tile.push_back(sorted[a - 1]);
+            else if (c > 0) tile.push_back(anchor);
+            total += tile_length(tile);
+        }
+        anchor = sorted[lo];
+    }
+    return total;
+}
+
+long long RsmtEstimator::tile_length(vector<Point>& pins) {
+    if (pins.size() <= 4) return small_net(pins.data(), pins.size());
+    sort_points(pins.data(), pins.data() + pins.size(), false);
+    return mst_steiner_length(pins);
+}
+
+long long RsmtEstimator::mst_steiner_length(const vector<Point>& pins) {
+    const int n = pins.size();
+
+    vector<Edge> candidates;
+    candidates.reserve(4 * n);
+    vector<int> ids(n);
+    iota(ids.begin(), ids.end(), 0);
+    octant_edges(pins, ids, candidates);
+
+    // Transposed pins sorted by (y, x); ties in y keep the x order of the input
+    long long ymin = pins[0].y;
+    for (const Point& p : pins) ymin = min<long long>(ymin, p.y);
+    const int shift = bit_width(n);
+    vector<uint64_t> by_y(n);
+    for (int i = 0; i < n; ++i) by_y[i] = uint64_t(pins[i].y - ymin) << shift | i;
+    radix_sort(by_y);
+    vector<Point> transposed(n);
+    for (int k = 0; k < n; ++k) {
+        ids[k] = by_y[k] & ((uint64_t(1) << shift) - 1);
+        transposed[k] = Point(pins[ids[k]].y, pins[ids[k]].x);
+    }
+    octant_edges(transposed, ids, candidates);
+
+    // Kruskal over the octant candidates, sorted as packed (length, index)
+    const int ebits = bit_width(candidates.size());
+    vector<uint64_t> keyed(candidates.size());
+    for (size_t e = 0; e < candidates.size(); ++e) {
+        keyed[e] = uint64_t(candidates[e].len) << ebits | e;
+    }
+    radix_sort(keyed);
+
+    vector<int> up(n);
+    iota(up.begin(), up.end(), 0);
+    vector<Edge> mst;
+    mst.reserve(n - 1);
+    long long total = 0;
+    for (uint64_t key : keyed) {
+        const Edge& e = candidates[key & ((uint64_t(1) << ebits) - 1)];
+        int ra = find_root(up, e.a), rb = find_root(up, e.b);
+        if (ra == rb) continue;
+        up[ra] = rb;
+        mst.push_back(e);
+        total += e.len;
+        if (static_cast<int>(mst.size()) == n - 1) break;
+    }
+
+    // Incident MST edges of every node
+    vector<int> start(n + 1, 0), via(2 * mst.size());
+    for (const Edge& e : mst) {
+        ++start[e.a + 1];
+        ++start[e.b + 1];
+    }
+    partial_sum(start.begin(), start.end(), start.begin());
+    vector<int> fill_at(start.begin(), start.end() - 1);
+    for (size_t e = 0; e < mst.size(); ++e) {
+        via[fill_at[mst[e].a]++] = e;
+        via[fill_at[mst[e].b]++] = e;
+    }
+
+    // Every node with two or three of its MST neighbours is a subnet whose
+    // Steiner tree may be shorter than its star of MST edges. Only the
+    // closest few neighbours are tried, which bounds the work at hubs such
+    // as many pins stacked on one spot.
+    const int max_fanout = 8;
+    struct Star {
+        long long gain;
+        int center, edges[3], size;
+    };
+    vector<Star> stars;
+    stars.reserve(n);
+    vector<int> near;
+    for (int v = 0; v < n; ++v) {
+        near.assign(via.begin() + start[v], via.begin() + start[v + 1]);
+        if (static_cast<int>(near.size()) > max_fanout) {
+            partial_sort(near.begin(), near.begin() + max_fanout, near.end(),
+                         [&](int a, int b) { return mst[a].len < mst[b].len; });
+            near.resize(max_fanout);
+        }
+        auto other = [&](int e) { return pins[mst[e].a == v ? mst[e].b : mst[e].a]; };
+
+        const int deg = near.size();
+        Point net[4];
+        net[0] = pins[v];
+        for (int a = 0; a < deg; ++a) {
+            net[1] = other(near[a]);
+            for (int b = a + 1; b < deg; ++b) {
+                net[2] = other(near[b]);
+                long long star_len = mst[near[a]].len + mst[near[b]].len;
+                long long gain = star_len - small_net(net, 3);
+                if (gain > 0) stars.push_back({gain, v, {near[a], near[b], -1}, 2});
+                for (int c = b + 1; c < deg; ++c) {
+                    net[3] = other(near[c]);
+                    gain = star_len + mst[near[c]].len - small_net(net, 4);
+                    if (gain > 0) stars.push_back({gain, v, {near[a], near[b], near[c]}, 3});
+                }
+            }
+        }
+    }
+
+    // Take the best stars that share no MST edge; each replaced star stays a
+    // connected subtree, so the result is still a valid Steiner tree. Ties
+    // go to the lower center, i.e. star creation order.
+    long long top = 0;
+    for (const Star& s : stars) top = max(top, s.gain);
+    const int sbits = bit_width(stars.size());
+    vector<uint64_t> ranked(stars.size());
+    for (size_t k = 0; k < stars.size(); ++k) {
+        ranked[k] = uint64_t(top - stars[k].gain) << sbits | k;
+    }
+    radix_sort(ranked);
+    vector<char> used(mst.size(), 0);
+    for (uint64_t key : ranked) {
+        const Star& s = stars[key & ((uint64_t(1) << sbits) - 1)];
+        bool free = true;
+        for (int k = 0; k < s.size; ++k) free = free && !used[s.edges[k]];
+        if (!free) continue;
+        for (int k = 0; k < s.size; ++k) used[s.edges[k]] = 1;
+        total -= s.gain;
+    }
+    return total;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "geometry.hpp"
+#include <vector>
+
+// Rectilinear Steiner minimal tree length estimate in the spirit of FLUTE,
+// self-contained (no POWV/POST files).
+//
+// Nets of up to four pins are looked up: the pins' position sequence selects
+// the potentially optimal wirelength vectors (POWVs), whose dot products
+// with the x/y gap lengths give the exact RSMT length. Larger nets are
+// broken along a rectilinear MST built from octant nearest neighbours in
+// O(n log n); every star of a node and two or three MST neighbours is a
+// candidate subnet, and the best edge-disjoint ones are replaced by their
+// looked-up Steiner length. Nets above tile_pins pins are first cut into
+// tiles of that size that share one pin with a neighbour.
+class RsmtEstimator {
+public:
+    static long long wirelength(const std::vector<Point>& pins);
+
+    // Exact RSMT length of at most four pins
+    static long long small_net(const Point* pins, int count);
+
+private:
+    static constexpr int tile_pins = 16384;
+
+    // Length of one tile; sorts `pins` by (x, y) on the way
+    static long long tile_length(std::vector<Point>& pins);
+
+    // Net breaking along the MST of pins sorted by (x, y)
+    static long long mst_steiner_length(const std::vector<Point>& sorted);
+};
@@ -0,0 +1,89 @@
+#include "segment_merge.hpp"
+#include <algorithm>
+using namespace std;
+
+namespace {
+
+struct Interval {
+    int track, lo, hi;
+};
+
+// Groups intervals by track with a counting sort when the track range is
+// comparable to the count (tracks are die coordinates), then orders each
+// bucket by start; the buckets are small, so this stays close to linear
+void sort_by_track(vector<Interval>& intervals) {
+    if (intervals.empty()) return;
+    auto [low, high] = minmax_element(intervals.begin(), intervals.end(),
+                                      [](const Interval& a, const Interval& b) {
+                                          return a.track < b.track;
+                                      });
+    long long range = static_cast<long long>(high->track) - low->track + 1;
+    auto by_start = [](const Interval& a, const Interval& b) {
+        return a.lo != b.lo ? a.lo < b.lo : a.hi < b.hi;
+    };
+
+    if (range > 4 * static_cast<long long>(intervals.size()) + 1024) {
+        sort(intervals.begin(), intervals.end(), [&](const Interval& a, const Interval& b) {
+            return a.track != b.track ? a.track < b.track : by_start(a, b);
+        });
+        return;
+    }
+
+    int base = low->track;
+    vector<int> start(range + 1, 0);
+    for (const Interval& s : intervals) ++start[s.track - base + 1];
+    for (long long t = 0; t < range; ++t) start[t + 1] += start[t];
+    vector<Interval> bucketed(intervals.size());
+    vector<int> at(start.begin(), start.end() - 1);
+    for (const Interval& s : intervals) bucketed[at[s.track - base]++] = s;
+    for (long long t = 0; t < range; ++t) {
+        if (start[t + 1] - start[t] > 1) {
+            sort(bucketed.begin() + start[t], bucketed.begin() + start[t + 1], by_start);
+        }
+    }
+    intervals.swap(bucketed);
+}
+
+// One sweep per track: extend the open run while the next interval starts
+// at or before its end
+template <typename Emit>
+void merge_runs(vector<Interval>& intervals, Emit emit) {
+    sort_by_track(intervals);
+    for (size_t k = 0; k < intervals.size();) {
+        Interval run = intervals[k++];
+        while (k < intervals.size() && intervals[k].track == run.track &&
+               intervals[k].lo <= run.hi) {
+            run.hi = max(run.hi, intervals[k++].hi);
+        }
+        emit(run);
+    }
+}
+
+}  // namespace
+
+vector<LineSegment> merge_collinear(const vector<LineSegment>& segments) {
+    vector<Interval> horizontal, vertical;
+    for (const LineSegment& s : segments) {
+        if (s.start.y == s.end.y && s.start.x != s.end.x) {
+            horizontal.push_back({s.start.y, min(s.start.x, s.end.x), max(s.start.x, s.end.x)});
+        } else if (s.start.x == s.end.x && s.start.y != s.end.y) {
+            vertical.push_back({s.start.x, min(s.start.y, s.end.y), max(s.start.y, s.end.y)});
+        }
+    }
+
+    vector<LineSegment> merged;
+    merged.reserve(horizontal.size() + vertical.size());
+    merge_runs(horizontal, [&](const Interval& run) {
+        merged.emplace_back(Point(run.lo, run.track), Point(run.hi, run.track));
+    });
+    merge_runs(vertical, [&](const Interval& run) {
+        merged.emplace_back(Point(run.track, run.lo), Point(run.track, run.hi));
+    });
+    return merged;
+}
+
+long long wire_length(const vector<LineSegment>& segments) {
+    long long total = 0;
+    for (const LineSegment& s : segments) total += manhattan_distance(s.start, s.end);
+    return total;
+}
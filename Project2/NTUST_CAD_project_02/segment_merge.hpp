@@ -0,0 +1,12 @@
+#pragma once
+#include "geometry.hpp"
+#include <vector>
+
+// Union of rectilinear segments as maximal runs: pieces on the same track
+// (y for horizontal, x for vertical) that overlap or touch become a single
+// segment, so shared wire is stored and counted once. Horizontal runs come
+// first; within each orientation runs are ordered by track, then by start,
+// and every run points right or up. Zero-length pieces are dropped.
+std::vector<LineSegment> merge_collinear(const std::vector<LineSegment>& segments);
+
+long long wire_length(const std::vector<LineSegment>& segments);
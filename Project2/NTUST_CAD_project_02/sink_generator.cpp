@@ -0,0 +1,132 @@
+#include "sink_generator.hpp"
+#include "buffered_writer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+using namespace std;
+
+namespace {
+// SplitMix64 with integer-only range reduction
+class Random {
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, bound)
+    int below(int bound) { return static_cast<int>(((next() >> 32) * static_cast<uint64_t>(bound)) >> 32); }
+
+    // Bell-shaped in [-spread, spread]: mean of four uniforms
+    int bell(int spread) {
+        long long sum = 0;
+        for (int k = 0; k < 4; ++k) sum += below(2 * spread + 1);
+        return static_cast<int>(sum / 4) - spread;
+    }
+
+private:
+    uint64_t state;
+};
+
+struct Rect {
+    int x0, y0, x1, y1;
+    bool contains(int x, int y) const { return x > x0 && x < x1 && y > y0 && y < y1; }
+};
+
+int clamp_to(int value, int side) { return min(max(value, 0), side); }
+}
+
+SinkPattern SinkGenerator::parse_pattern(const string& name) {
+    if (name == "uniform") return SinkPattern::Uniform;
+    if (name == "clustered") return SinkPattern::Clustered;
+    if (name == "macro") return SinkPattern::Macro;
+    throw invalid_argument("Unknown sink pattern: " + name);
+}
+
+const char* SinkGenerator::pattern_name(SinkPattern pattern) {
+    switch (pattern) {
+    case SinkPattern::Uniform: return "uniform";
+    case SinkPattern::Clustered: return "clustered";
+    case SinkPattern::Macro: return "macro";
+    }
+    return "";
+}
+
+CtsDesign SinkGenerator::generate(SinkPattern pattern, int sinks, uint64_t seed) {
+    if (sinks < 1) throw invalid_argument("Sink count must be positive");
+    const int side = max(1000, pitch * static_cast<int>(ceil(sqrt(static_cast<double>(sinks)))));
+    // Decorrelate the patterns for one seed
+    Random random(seed * 3 + static_cast<int>(pattern));
+
+    CtsDesign design;
+    design.dimX = design.dimY = side;
+    design.source = Point(side / 2, 0);
+    design.sinks.reserve(sinks);
+
+    if (pattern == SinkPattern::Uniform) {
+        for (int i = 0; i < sinks; ++i) design.sinks.emplace_back(random.below(side + 1), random.below(side + 1));
+    } else if (pattern == SinkPattern::Clustered) {
+        // About 500 flops per bank
+        const int clusters = max(1, sinks / 500);
+        const int spread = max(1, static_cast<int>(side / (2 * sqrt(static_cast<double>(clusters)))));
+        vector<Point> centers;
+        for (int k = 0; k < clusters; ++k) centers.emplace_back(random.below(side + 1), random.below(side + 1));
+        for (int i = 0; i < sinks; ++i) {
+            const Point& c = centers[random.below(clusters)];
+            design.sinks.emplace_back(clamp_to(c.x + random.bell(spread), side),
+                                      clamp_to(c.y + random.bell(spread), side));
+        }
+    } else {
+        // Twelve macros of 1/16 to 1/5 of the die side; a quarter of the
+        // sinks sit just outside a macro edge, the rest anywhere free
+        vector<Rect> macros;
+        for (int k = 0; k < 12; ++k) {
+            int w = side / 16 + random.below(side / 5 - side / 16 + 1);
+            int h = side / 16 + random.below(side / 5 - side / 16 + 1);
+            int x = random.below(side - w + 1), y = random.below(side - h + 1);
+            macros.push_back({x, y, x + w, y + h});
+        }
+        auto blocked = [&](int x, int y) {
+            for (const Rect& m : macros) {
+                if (m.contains(x, y)) return true;
+            }
+            return false;
+        };
+        while (static_cast<int>(design.sinks.size()) < sinks) {
+            int x, y;
+            if (random.below(4) == 0) {
+                const Rect& m = macros[random.below(macros.size())];
+                int gap = 1 + random.below(pitch);
+                switch (random.below(4)) {
+                case 0: x = m.x0 + random.below(m.x1 - m.x0 + 1); y = m.y0 - gap; break;
+                case 1: x = m.x0 + random.below(m.x1 - m.x0 + 1); y = m.y1 + gap; break;
+                case 2: x = m.x0 - gap; y = m.y0 + random.below(m.y1 - m.y0 + 1); break;
+                default: x = m.x1 + gap; y = m.y0 + random.below(m.y1 - m.y0 + 1); break;
+                }
+                x = clamp_to(x, side);
+                y = clamp_to(y, side);
+            } else {
+                x = random.below(side + 1);
+                y = random.below(side + 1);
+            }
+            if (!blocked(x, y)) design.sinks.emplace_back(x, y);
+        }
+    }
+    return design;
+}
+
+void SinkGenerator::write(const string& filename, const CtsDesign& design) {
+    BufferedWriter file(filename);
+    file << ".p " << design.sinks.size() + 1 << '\n';
+    file << ".dimx " << design.dimX << '\n';
+    file << ".dimy " << design.dimY << '\n';
+    file << design.source.x << ' ' << design.source.y << '\n';
+    for (const Point& sink : design.sinks) file << sink.x << ' ' << sink.y << '\n';
+    file << ".e\n";
+    file.close();
+}
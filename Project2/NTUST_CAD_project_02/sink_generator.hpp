@@ -0,0 +1,27 @@
+#pragma once
+#include "cts_reader.hpp"
+#include <cstdint>
+#include <string>
+
+enum class SinkPattern {
+    Uniform,    // Sinks spread evenly over the die
+    Clustered,  // Register banks: dense bell-shaped clusters
+    Macro       // Uniform around rectangular macros, with sinks lining their edges
+};
+
+// Synthetic .cts designs for scaling runs. The die grows with the sink
+// count at a fixed pitch and the source sits at the middle of the bottom
+// edge. All randomness comes from a SplitMix64 stream with integer-only
+// sampling, so a (pattern, count, seed) triple gives the same sinks on
+// every platform and compiler.
+class SinkGenerator {
+public:
+    static constexpr int pitch = 100;  // Die units per sink along each side
+
+    // Throws invalid_argument for an unknown name
+    static SinkPattern parse_pattern(const std::string& name);
+    static const char* pattern_name(SinkPattern pattern);
+
+    static CtsDesign generate(SinkPattern pattern, int sinks, std::uint64_t seed);
+    static void write(const std::string& filename, const CtsDesign& design);
+};
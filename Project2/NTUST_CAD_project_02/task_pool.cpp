@@ -0,0 +1,124 @@
+#include "task_pool.hpp"
+#include "memory_tracker.hpp"
+using namespace std;
+
+namespace {
+thread_local const TaskPool* current_pool = nullptr;
+thread_local int current_worker = 0;
+}
+
+TaskPool::TaskPool(int threads) {
+    int count = max(1, threads);
+    for (int i = 0; i < count; ++i) queues.push_back(make_unique<Queue>());
+    for (int i = 1; i < count; ++i) this->threads.emplace_back(&TaskPool::worker_loop, this, i);
+}
+
+TaskPool::~TaskPool() {
+    {
+        lock_guard<mutex> guard(idle_lock);
+        stopping = true;
+    }
+    idle.notify_all();
+    for (thread& t : threads) t.join();
+}
+
+int TaskPool::worker() const {
+    return current_pool == this ? current_worker : 0;
+}
+
+void TaskPool::spawn(Group& group, function<void()> task) {
+    group.pending.fetch_add(1);
+    Queue& queue = *queues[worker()];
+    // The task's heap is charged to the spawner wherever the task runs
+    HeapTracker::Account& account = HeapTracker::current();
+    {
+        lock_guard<mutex> guard(queue.lock);
+        queue.tasks.emplace_back([this, &group, &account, task = move(task)] {
+            HeapTracker::Scope charge(account);
+            // Counted down however the task ends, so wait() always returns
+            struct Done {
+                TaskPool& pool;
+                Group& group;
+                ~Done() { pool.finish(group); }
+            } done{*this, group};
+            try {
+                task();
+            } catch (...) {
+                lock_guard<mutex> guard(group.error_lock);
+                if (!group.error) group.error = current_exception();
+            }
+        });
+    }
+    queued.fetch_add(1);
+    if (size() > 1) {
+        lock_guard<mutex> guard(idle_lock);
+        idle.notify_one();
+    }
+}
+
+bool TaskPool::run_one(int self) {
+    function<void()> task;
+
+    // Own tasks newest first, then the oldest task of another worker
+    for (int k = 0; k < size() && !task; ++k) {
+        Queue& queue = *queues[(self + k) % size()];
+        lock_guard<mutex> guard(queue.lock);
+        if (queue.tasks.empty()) continue;
+        if (k == 0) {
+            task = move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if (!task) return false;
+
+    queued.fetch_sub(1);
+    task();
+    return true;
+}
+
+void TaskPool::finish(Group& group) {
+    if (group.pending.fetch_sub(1) == 1) {
+        // Taking the lock orders this with a waiter checking `pending`
+        { lock_guard<mutex> guard(idle_lock); }
+        idle.notify_all();
+    }
+}
+
+void TaskPool::wait(Group& group) {
+    const TaskPool* outer_pool = current_pool;
+    int outer_worker = current_worker;
+    int self = worker();
+    current_pool = this;
+    current_worker = self;
+
+    // Sleep while the group's remaining tasks run elsewhere and nothing is
+    // queued to help with
+    while (group.pending.load() > 0) {
+        if (run_one(self)) continue;
+        unique_lock<mutex> guard(idle_lock);
+        idle.wait(guard, [&] { return group.pending.load() == 0 || queued.load() > 0; });
+    }
+
+    current_pool = outer_pool;
+    current_worker = outer_worker;
+
+    if (group.error) {
+        exception_ptr error = group.error;
+        group.error = nullptr;
+        rethrow_exception(error);
+    }
+}
+
+void TaskPool::worker_loop(int self) {
+    current_pool = this;
+    current_worker = self;
+    while (true) {
+        if (run_one(self)) continue;
+        unique_lock<mutex> guard(idle_lock);
+        idle.wait(guard, [&] { return stopping || queued.load() > 0; });
+        if (stopping) return;
+    }
+}
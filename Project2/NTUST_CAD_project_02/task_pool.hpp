@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool for fork-join recursion. Every worker owns a deque: it
+// pushes and pops its own tasks at the back, depth first, while idle workers
+// steal from the front, where the biggest pending subproblems sit. The
+// thread that calls wait() acts as worker 0 in the meantime, so a task
+// waiting for its children keeps running other tasks, and sleeps only when
+// there is nothing left to take.
+class TaskPool {
+public:
+    // Tasks spawned together; wait() returns once all of them finished and
+    // rethrows the first exception any of them threw
+    class Group {
+        friend class TaskPool;
+        std::atomic<int> pending{0};
+        std::mutex error_lock;
+        std::exception_ptr error;
+    };
+
+    explicit TaskPool(int threads);
+    ~TaskPool();
+
+    int size() const { return static_cast<int>(queues.size()); }
+
+    // Index of the calling thread in [0, size()); threads outside the pool
+    // count as worker 0
+    int worker() const;
+
+    void spawn(Group& group, std::function<void()> task);
+    void wait(Group& group);
+
+    // body(i) for i in [0, count), spread over the workers
+    template <typename F>
+    void parallel_for(int count, F body) {
+        Group group;
+        for (int i = 0; i < count; ++i) spawn(group, [&body, i] { body(i); });
+        wait(group);
+    }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<int> queued{0};
+    std::atomic<bool> stopping{false};
+    std::mutex idle_lock;
+    std::condition_variable idle;
+
+    bool run_one(int self);
+    void finish(Group& group);
+    void worker_loop(int self);
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Whitespace-separated tokens of a mapped text file, read in place.
+// Keywords start with '.'; errors throw runtime_error naming the line.
+class Tokenizer {
+public:
+    Tokenizer(const char* begin, const char* end, const std::string& filename)
+        : start(begin), cursor(begin), limit(end), filename(filename) {}
+
+    // Skips whitespace; false once the input is exhausted
+    bool next() {
+        while (cursor < limit && (*cursor == ' ' || *cursor == '\n' || *cursor == '\r' ||
+                                  *cursor == '\t')) {
+            ++cursor;
+        }
+        return cursor < limit;
+    }
+
+    bool at_keyword() const { return *cursor == '.'; }
+
+    std::string_view word() {
+        const char* from = cursor;
+        while (cursor < limit && *cursor != ' ' && *cursor != '\n' && *cursor != '\r' &&
+               *cursor != '\t') {
+            ++cursor;
+        }
+        return std::string_view(from, cursor - from);
+    }
+
+    int integer() {
+        if (!next()) fail("unexpected end of file");
+        int value = 0;
+        auto [end, error] = std::from_chars(cursor, limit, value);
+        if (error != std::errc() ||
+            (end < limit && *end != ' ' && *end != '\n' && *end != '\r' && *end != '\t')) {
+            fail("expected an integer");
+        }
+        cursor = end;
+        return value;
+    }
+
+    [[noreturn]] void fail(const std::string& message) const {
+        long long line = 1 + std::count(start, cursor, '\n');
+        throw std::runtime_error(filename + ":" + std::to_string(line) + ": " + message);
+    }
+
+private:
+    const char* start;
+    const char* cursor;
+    const char* limit;
+    const std::string& filename;
+};
@@ -0,0 +1,184 @@
+#include "tree_eval.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+using namespace std;
+
+TreeEvaluator::TreeEvaluator(const FlatTree& tree, RcModel model)
+    : tree(tree), model(model) {}
+
+void TreeEvaluator::compute_order() {
+    const int n = tree.size();
+    order.clear();
+    order.reserve(n);
+    tin.assign(n, 0);
+    tout.assign(n, 0);
+    if (tree.get_root() < 0) return;
+
+    vector<int> stack = {tree.get_root()};
+    while (!stack.empty()) {
+        int node = stack.back();
+        stack.pop_back();
+        tin[node] = order.size();
+        order.push_back(node);
+        for (int c = tree.first_child(node); c >= 0; c = tree.next_sibling(c)) {
+            stack.push_back(c);
+        }
+    }
+
+    // Subtree sizes in reverse pre-order give the end of each range
+    vector<int> subtree(n, 1);
+    for (int k = static_cast<int>(order.size()) - 1; k >= 0; --k) {
+        int node = order[k];
+        tout[node] = tin[node] + subtree[node];
+        if (tree.parent(node) >= 0) subtree[tree.parent(node)] += subtree[node];
+    }
+}
+
+double TreeEvaluator::wire_delay(int node) const {
+    double w = tree.wire(node);
+    return model.r * w * (model.c * w / 2 + cap[node]);
+}
+
+void TreeEvaluator::evaluate() {
+    compute_order();
+    const int n = tree.size();
+    cap.assign(n, 0.0);
+    wires.assign(n, 0);
+    sink_count = 0;
+
+    // Post-order: capacitance below each node's wire
+    for (int k = static_cast<int>(order.size()) - 1; k >= 0; --k) {
+        int node = order[k];
+        if (tree.kind(node) == NodeKind::Sink) {
+            cap[node] += model.sink_cap;
+            ++sink_count;
+        }
+        wires[node] = tree.wire(node);
+        int p = tree.parent(node);
+        if (p >= 0) cap[p] += cap[node] + model.c * tree.wire(node);
+    }
+
+    // Pre-order: path length and delay accumulate from the source
+    vector<double> path(order.size(), 0.0), delay(order.size(), 0.0);
+    vector<char> is_sink(order.size(), 0);
+    for (size_t k = 0; k < order.size(); ++k) {
+        int node = order[k];
+        int p = tree.parent(node);
+        if (p >= 0) {
+            path[k] = path[tin[p]] + tree.wire(node);
+            delay[k] = delay[tin[p]] + wire_delay(node);
+        }
+        is_sink[k] = tree.kind(node) == NodeKind::Sink;
+    }
+    paths.build(path, is_sink);
+    delays.build(delay, is_sink);
+}
+
+void TreeEvaluator::update_subtree(int node) {
+    int p = tree.parent(node);
+    if (p < 0) {
+        evaluate();
+        return;
+    }
+
+    // Capacitance inside the subtree, children before parents
+    double old_load = cap[node] + model.c * wires[node];
+    for (int k = tout[node] - 1; k >= tin[node]; --k) {
+        int x = order[k];
+        double c = tree.kind(x) == NodeKind::Sink ? model.sink_cap : 0.0;
+        for (int ch = tree.first_child(x); ch >= 0; ch = tree.next_sibling(ch)) {
+            c += cap[ch] + model.c * tree.wire(ch);
+        }
+        cap[x] = c;
+        wires[x] = tree.wire(x);
+    }
+    double delta = cap[node] + model.c * tree.wire(node) - old_load;
+
+    // Every ancestor now drives `delta` more, which slows down its whole
+    // pre-order range by the resistance of its own wire
+    if (delta != 0) {
+        for (int a = p; a >= 0; a = tree.parent(a)) {
+            cap[a] += delta;
+            if (tree.parent(a) >= 0) {
+                delays.add(tin[a], tout[a], model.r * tree.wire(a) * delta);
+            }
+        }
+    }
+
+    // Re-derive the subtree itself from its parent's current values
+    int base = tin[node];
+    vector<double> path(tout[node] - base), delay(tout[node] - base);
+    for (int k = base; k < tout[node]; ++k) {
+        int x = order[k];
+        int q = tree.parent(x);
+        double parent_path = q == p ? paths.get(tin[p]) : path[tin[q] - base];
+        double parent_delay = q == p ? delays.get(tin[p]) : delay[tin[q] - base];
+        path[k - base] = parent_path + tree.wire(x);
+        delay[k - base] = parent_delay + wire_delay(x);
+        paths.set(k, path[k - base]);
+        delays.set(k, delay[k - base]);
+    }
+}
+
+long long TreeEvaluator::path_length(int node) const {
+    return llround(paths.get(tin[node]));
+}
+
+double TreeEvaluator::elmore_delay(int node) const {
+    return delays.get(tin[node]);
+}
+
+void TreeEvaluator::MinMaxTree::build(const vector<double>& values, const vector<char>& mask) {
+    const int n = values.size();
+    size = 1;
+    while (size < n) size *= 2;
+    raw.assign(size, 0.0);
+    counted.assign(size, 0);
+    lazy.assign(2 * size, 0.0);
+    lo_val.assign(2 * size, numeric_limits<double>::infinity());
+    hi_val.assign(2 * size, -numeric_limits<double>::infinity());
+
+    for (int i = 0; i < n; ++i) {
+        raw[i] = values[i];
+        counted[i] = mask[i];
+        if (mask[i]) lo_val[size + i] = hi_val[size + i] = values[i];
+    }
+    for (int k = size - 1; k >= 1; --k) pull(k);
+}
+
+void TreeEvaluator::MinMaxTree::pull(int k) {
+    lo_val[k] = std::min(lo_val[2 * k], lo_val[2 * k + 1]) + lazy[k];
+    hi_val[k] = std::max(hi_val[2 * k], hi_val[2 * k + 1]) + lazy[k];
+}
+
+void TreeEvaluator::MinMaxTree::add(int k, int l, int r, int lo, int hi, double delta) {
+    if (hi <= l || r <= lo) return;
+    if (lo <= l && r <= hi) {
+        lazy[k] += delta;
+        lo_val[k] += delta;
+        hi_val[k] += delta;
+        return;
+    }
+    int mid = (l + r) / 2;
+    add(2 * k, l, mid, lo, hi, delta);
+    add(2 * k + 1, mid, r, lo, hi, delta);
+    pull(k);
+}
+
+void TreeEvaluator::MinMaxTree::set(int pos, double value) {
+    int leaf = size + pos;
+    double above = 0;
+    for (int k = leaf >> 1; k >= 1; k >>= 1) above += lazy[k];
+
+    raw[pos] = value - above;
+    lazy[leaf] = 0;
+    if (counted[pos]) lo_val[leaf] = hi_val[leaf] = raw[pos];
+    for (int k = leaf >> 1; k >= 1; k >>= 1) pull(k);
+}
+
+double TreeEvaluator::MinMaxTree::get(int pos) const {
+    double value = raw[pos];
+    for (int k = size + pos; k >= 1; k >>= 1) value += lazy[k];
+    return value;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "flat_tree.hpp"
+#include <cmath>
+#include <vector>
+
+// Per-unit-length wire parasitics and sink load. With r in ohm and c in fF
+// Elmore delays come out in fs.
+struct RcModel {
+    double r = 0.1;         // Wire resistance per unit length
+    double c = 0.2;         // Wire capacitance per unit length
+    double sink_cap = 1.0;  // Load of every sink
+};
+
+// Source-to-node path length and Elmore delay of every node of a FlatTree.
+//
+// evaluate() is one post-order sweep (downstream capacitance) and one
+// pre-order sweep (path length and delay). Values sit in pre-order position
+// in two segment trees, so that after re-embedding a subtree only that
+// subtree is recomputed and the capacitance change above it is pushed to
+// every ancestor's pre-order range as a lazy add: O(|subtree| log n +
+// depth log n) instead of a full walk. Sink extremes are kept at the roots.
+class TreeEvaluator {
+public:
+    TreeEvaluator(const FlatTree& tree, RcModel model = RcModel());
+
+    // Full O(n) evaluation; required again after the topology changes
+    void evaluate();
+
+    // Refresh after the positions and wires of `node` and its descendants
+    // changed while the topology stayed the same
+    void update_subtree(int node);
+
+    const RcModel& rc_model() const { return model; }
+    long long path_length(int node) const;
+    double elmore_delay(int node) const;
+
+    // Extremes over the sinks; 0 for a tree without sinks
+    long long max_path() const { return sink_count ? llround(paths.max()) : 0; }
+    long long min_path() const { return sink_count ? llround(paths.min()) : 0; }
+    double max_delay() const { return sink_count ? delays.max() : 0.0; }
+    double min_delay() const { return sink_count ? delays.min() : 0.0; }
+
+private:
+    // Range add, point set/get, min and max over sink positions only; lazy
+    // tags stay on their node instead of being pushed down
+    class MinMaxTree {
+    public:
+        void build(const std::vector<double>& values, const std::vector<char>& counted);
+        void add(int lo, int hi, double delta) { add(1, 0, size, lo, hi, delta); }
+        void set(int pos, double value);
+        double get(int pos) const;
+        double min() const { return lo_val[1]; }
+        double max() const { return hi_val[1]; }
+
+    private:
+        int size = 1;
+        std::vector<double> lo_val, hi_val, lazy, raw;
+        std::vector<char> counted;
+
+        void add(int k, int l, int r, int lo, int hi, double delta);
+        void pull(int k);
+    };
+
+    const FlatTree& tree;
+    RcModel model;
+    std::vector<int> order;         // Pre-order of node indices
+    std::vector<int> tin, tout;     // Pre-order range [tin, tout) of each subtree
+    std::vector<double> cap;        // Capacitance seen below each node's wire
+    std::vector<int> wires;         // Wire lengths as of the last evaluation
+    int sink_count = 0;
+    MinMaxTree paths, delays;
+
+    void compute_order();
+    double wire_delay(int node) const;
+};
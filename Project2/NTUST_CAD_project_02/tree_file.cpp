@@ -0,0 +1,74 @@
+#include "tree_file.hpp"
+#include "buffered_writer.hpp"
+#include "mapped_file.hpp"
+#include "tokenizer.hpp"
+#include <vector>
+using namespace std;
+
+void write_tree_file(const string& filename, const FlatTree& tree) {
+    vector<int> order, index(tree.size(), -1);
+    order.reserve(tree.size());
+    if (tree.get_root() >= 0) {
+        vector<int> stack = {tree.get_root()};
+        while (!stack.empty()) {
+            int node = stack.back();
+            stack.pop_back();
+            index[node] = order.size();
+            order.push_back(node);
+            for (int c = tree.first_child(node); c >= 0; c = tree.next_sibling(c)) stack.push_back(c);
+        }
+    }
+
+    BufferedWriter file(filename);
+    file << ".n " << order.size() << '\n';
+    file << ".dimx " << tree.die_x() << '\n';
+    file << ".dimy " << tree.die_y() << '\n';
+    for (int node : order) {
+        int parent = tree.parent(node);
+        file << tree.x(node) << ' ' << tree.y(node) << ' ' << (parent < 0 ? -1 : index[parent])
+             << ' ' << tree.wire(node) << ' ' << static_cast<int>(tree.kind(node)) << '\n';
+    }
+    file << ".e\n";
+    file.close();
+}
+
+void read_tree_file(const string& filename, FlatTree& tree) {
+    MappedFile file(filename);
+    Tokenizer tokens(file.begin(), file.end(), filename);
+
+    tree.clear();
+    int dimX = 0, dimY = 0;
+    while (tokens.next()) {
+        if (tokens.at_keyword()) {
+            string_view keyword = tokens.word();
+            if (keyword == ".e") {
+                break;
+            } else if (keyword == ".n") {
+                int declared = tokens.integer();
+                if (declared < 0) tokens.fail("negative node count");
+                tree.reserve(declared);
+            } else if (keyword == ".dimx") {
+                dimX = tokens.integer();
+            } else if (keyword == ".dimy") {
+                dimY = tokens.integer();
+            } else {
+                tokens.fail("unknown keyword " + string(keyword));
+            }
+            continue;
+        }
+
+        int x = tokens.integer();
+        int y = tokens.integer();
+        int parent = tokens.integer();
+        int wire = tokens.integer();
+        int kind = tokens.integer();
+        if ((tree.size() == 0) != (parent < 0) || parent >= tree.size()) {
+            tokens.fail("parent must be -1 for the first node and an earlier node after it");
+        }
+        if (wire < 0) tokens.fail("negative wire length");
+        if (kind < 0 || kind > static_cast<int>(NodeKind::Steiner)) tokens.fail("bad node kind");
+        tree.add_node(x, y, parent, wire, static_cast<NodeKind>(kind));
+    }
+    if (tree.size() == 0) tokens.fail("no nodes");
+    tree.set_die(dimX, dimY);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "flat_tree.hpp"
+#include <string>
+
+// Tree snapshot, so a synthesized tree can be reloaded for ECOs:
+//
+//   .n COUNT
+//   .dimx X
+//   .dimy Y
+//   X Y PARENT WIRE KIND     one line per node, KIND 0 source, 1 sink, 2 Steiner
+//   .e
+//
+// Nodes are written in pre-order from the root, so every parent precedes
+// its children and the root (parent -1) comes first. Detached nodes are
+// left out and the rest renumbered.
+void write_tree_file(const std::string& filename, const FlatTree& tree);
+
+// Replaces `tree`; malformed input throws runtime_error naming the line
+void read_tree_file(const std::string& filename, FlatTree& tree);
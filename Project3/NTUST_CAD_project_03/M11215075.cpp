@@ -1,41 +1,27 @@
 #include <iostream>
-#include <fstream>
 #include <string>
-#include <sstream>
 #include <vector>
-#include <map>
 #include <cmath>
 #include <limits>
 #include <iomanip>
 #include <filesystem>
+#include <future>
 #include <algorithm>
 #include <random>
 #include <chrono>
+#include <thread>
+#include "bookshelf.hpp"
+#include "bookshelf_writer.hpp"
+#include "cell_store.hpp"
+#include "detailed_placer.hpp"
+#include "hpwl.hpp"
+#include "overlap_checker.hpp"
+#include "placement_renderer.hpp"
+#include "region_legalizer.hpp"
+#include "site_rows.hpp"
 
 namespace fs = std::filesystem;
 
-// Node structure definition
-struct Node
-{
-    std::string name;
-    double width;
-    double height;
-    bool is_terminal;
-    double original_x;
-    double original_y;
-    double new_x;
-    double new_y;
-    std::string orientation;
-    bool is_fixed;
-
-    // Force vectors for diffusion
-    double force_x;
-    double force_y;
-    // Velocity vectors for momentum
-    double velocity_x;
-    double velocity_y;
-};
-
 // Die area structure definition
 struct DieArea
 {
@@ -45,307 +31,53 @@ struct DieArea
     double max_y;
 };
 
+// Command-line settings of one run
+struct LegalizerOptions
+{
+    std::string engine = "greedy";    // "greedy" or "abacus"
+    int row_window = 32;              // Rows an abacus cell tries once one fits
+    int regions = 1;                  // Row stripes legalized in parallel by abacus
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    bool list_overlaps = false;       // Print every overlapping pair
+    int passes = 0;                   // Detailed placement passes after legalization
+    double displacement_weight = 1.0; // Cost of displacement against HPWL in those passes
+    bool plots = true;                // Render the input and output placements
+};
+
 class CircuitLegalizer
 {
 private:
+    LegalizerOptions options;
     fs::path input_dir;
     fs::path output_dir;
     std::string input_name;
     std::string output_name;
-    std::vector<Node> nodes;
-    std::map<std::string, std::vector<std::string>> file_headers;
+    BookshelfDesign design; // Also holds the cold fields: names and orientations
+    CellStore cells;
     DieArea die_area;
     double total_displacement;
     double max_displacement;
     double row_height;
 
-    struct Row
-    {
-        double y_coordinate;
-        double right_edge;
-        double width;
-        std::vector<Node *> cells;
-
-        Row(double y, double w) : y_coordinate(y), right_edge(0), width(w) {}
-    };
-
-    double calculateDisplacement(const Node &node, double new_x, double new_y)
-    {
-        return std::abs(new_x - node.original_x) + std::abs(new_y - node.original_y);
-    }
-
-    // File Processing Methods
-    void processAuxFile()
-    {
-        std::string input_file = (input_dir / (input_name + ".aux")).string();
-        std::string output_file = (output_dir / (output_name + ".aux")).string();
-
-        std::ifstream in(input_file);
-        if (!in.is_open())
-        {
-            throw std::runtime_error("Cannot open input .aux file: " + input_file);
-        }
-
-        std::vector<std::string> lines;
-        std::string line;
-        while (std::getline(in, line))
-        {
-            lines.push_back(line);
-        }
-        in.close();
-
-        std::ofstream out(output_file);
-        if (!out.is_open())
-        {
-            throw std::runtime_error("Cannot create output .aux file: " + output_file);
-        }
-
-        for (const auto &line : lines)
-        {
-            if (line.find("RowBasedPlacement") != std::string::npos)
-            {
-                // Replace input filenames with output filenames
-                out << "RowBasedPlacement : "
-                    << output_name << ".nodes "
-                    << output_name << ".nets "
-                    << output_name << ".wts "
-                    << output_name << ".pl "
-                    << output_name << ".scl" << std::endl;
-            }
-            else
-            {
-                out << line << std::endl;
-            }
-        }
-        out.close();
-    }
-    void processNodesFile()
+    double calculateDisplacement(int cell, double new_x, double new_y)
     {
-        std::string input_file = (input_dir / (input_name + ".nodes")).string();
-        std::string output_file = (output_dir / (output_name + ".nodes")).string();
-
-        std::ifstream in(input_file);
-        if (!in.is_open())
-        {
-            throw std::runtime_error("Cannot open input .nodes file: " + input_file);
-        }
-
-        std::vector<std::string> headers;
-        std::string line;
-        int node_count = 0;
-        int terminal_count = 0;
-
-        // First pass: read headers and count nodes
-        while (std::getline(in, line))
-        {
-            if (line.find("NumNodes") != std::string::npos ||
-                line.find("NumTerminals") != std::string::npos ||
-                line.empty() || line[0] == '#' ||
-                line.find("UCLA") != std::string::npos)
-            {
-                headers.push_back(line);
-                continue;
-            }
-
-            std::istringstream iss(line);
-            std::string name, terminal;
-            double width, height;
-
-            if (!(iss >> name >> width >> height))
-            {
-                headers.push_back(line);
-                continue;
-            }
-
-            node_count++;
-            if (iss >> terminal && terminal == "terminal")
-            {
-                terminal_count++;
-            }
-        }
-
-        // Reset file pointer and read node data
-        in.clear();
-        in.seekg(0);
-        nodes.clear();
-
-        bool reading_data = false;
-        while (std::getline(in, line))
-        {
-            if (!reading_data)
-            {
-                if (line.find("NumNodes") != std::string::npos ||
-                    line.find("NumTerminals") != std::string::npos ||
-                    line.empty() || line[0] == '#' ||
-                    line.find("UCLA") != std::string::npos)
-                {
-                    continue;
-                }
-                reading_data = true;
-            }
-
-            if (reading_data)
-            {
-                std::istringstream iss(line);
-                Node node;
-                std::string terminal;
-
-                if (!(iss >> node.name >> node.width >> node.height))
-                {
-                    continue;
-                }
-
-                node.is_terminal = iss >> terminal && terminal == "terminal";
-                node.is_fixed = false;
-                node.force_x = 0.0;
-                node.force_y = 0.0;
-                node.velocity_x = 0.0;
-                node.velocity_y = 0.0;
-                nodes.push_back(node);
-            }
-        }
-
-        in.close();
-
-        // Update file headers
-        for (auto &header : headers)
-        {
-            if (header.find("NumNodes") != std::string::npos)
-            {
-                header = "NumNodes : " + std::to_string(node_count);
-            }
-            else if (header.find("NumTerminals") != std::string::npos)
-            {
-                header = "NumTerminals : " + std::to_string(terminal_count);
-            }
-        }
-        file_headers[".nodes"] = headers;
-
-        // Write output file
-        std::ofstream out(output_file);
-        if (!out.is_open())
-        {
-            throw std::runtime_error("Cannot create output .nodes file: " + output_file);
-        }
-
-        for (const auto &header : headers)
-        {
-            out << header << std::endl;
-        }
-
-        for (const auto &node : nodes)
-        {
-            out << node.name << " "
-                << std::fixed << std::setprecision(1) << node.width << " "
-                << node.height;
-            if (node.is_terminal)
-            {
-                out << " terminal";
-            }
-            out << std::endl;
-        }
-        out.close();
-    }
-
-    void processPlFile()
-    {
-        std::string input_file = (input_dir / (input_name + ".pl")).string();
-        std::string output_file = (output_dir / (output_name + ".pl")).string();
-
-        std::ifstream in(input_file);
-        if (!in.is_open())
-        {
-            throw std::runtime_error("Cannot open input .pl file: " + input_file);
-        }
-
-        std::vector<std::string> headers;
-        std::string line;
-
-        while (std::getline(in, line))
-        {
-            if (line.find("UCLA pl 1.0") != std::string::npos)
-            {
-                headers.push_back(line);
-                break;
-            }
-            headers.push_back(line);
-        }
-
-        while (std::getline(in, line))
-        {
-            if (line.empty() || line[0] == '#')
-                continue;
-
-            std::istringstream iss(line);
-            std::string name, orientation, fixed;
-            double x, y;
-            char colon;
-
-            if (!(iss >> name >> x >> y >> colon >> orientation))
-                continue;
-
-            iss >> fixed;
-            bool is_fixed = (fixed == "/FIXED");
-
-            auto node_it = std::find_if(nodes.begin(), nodes.end(),
-                                        [&name](const Node &node)
-                                        {
-                                            return node.name == name;
-                                        });
-
-            if (node_it != nodes.end())
-            {
-                node_it->original_x = x;
-                node_it->original_y = y;
-                node_it->new_x = x;
-                node_it->new_y = y;
-                node_it->orientation = orientation;
-                node_it->is_fixed = is_fixed;
-            }
-        }
-
-        in.close();
-        file_headers[".pl"] = headers;
-
-        std::ofstream out(output_file);
-        if (!out.is_open())
-        {
-            throw std::runtime_error("Cannot create output .pl file: " + output_file);
-        }
-
-        for (const auto &header : headers)
-        {
-            out << header << std::endl;
-        }
-        out << std::endl;
-
-        for (const auto &node : nodes)
-        {
-            // Snap to row height
-            double snapped_y = std::round(node.new_y / row_height) * row_height;
-
-            out << std::left << std::setw(10) << node.name
-                << std::fixed << std::setprecision(1)
-                << std::right << std::setw(8) << node.new_x << "  "
-                << std::setw(8) << snapped_y << " : "
-                << node.orientation;
-            if (node.is_fixed)
-            {
-                out << " /FIXED";
-            }
-            out << std::endl;
-        }
-        out.close();
+        return std::abs(new_x - cells.x[cell]) + std::abs(new_y - cells.y[cell]);
     }
 
-    void processSclFile()
+    // Reads all input files and derives the die area from the rows
+    void readInputFiles()
     {
-        std::string input_file = (input_dir / (input_name + ".scl")).string();
-        std::ifstream in(input_file);
-        if (!in.is_open())
-        {
-            throw std::runtime_error("Cannot open input .scl file: " + input_file);
-        }
+        BookshelfReader reader;
+        reader.read(input_dir.string(), input_name, design);
+        auto flags = std::cout.flags();
+        auto precision = std::cout.precision();
+        std::cout << "Parsed " << input_name << ": " << reader.getBytes() << " bytes in "
+                  << std::fixed << std::setprecision(3) << reader.getSeconds() << " s ("
+                  << std::setprecision(1) << reader.getThroughput() << " MB/s)" << std::endl;
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+
+        cells.load(design);
 
         die_area = {
             .min_x = std::numeric_limits<double>::max(),
@@ -353,302 +85,218 @@ private:
             .min_y = std::numeric_limits<double>::max(),
             .max_y = std::numeric_limits<double>::lowest()};
 
-        row_height = 0.0; // Initialize row_height
-        std::string line;
-        int num_rows = 0;
-
-        while (std::getline(in, line))
+        row_height = 0.0;
+        for (const BookshelfRow &row : design.rows)
         {
-            if (line.find("NumRows") != std::string::npos)
-            {
-                std::istringstream iss(line);
-                std::string dummy;
-                iss >> dummy >> dummy >> num_rows;
-            }
-            else if (line.find("CoreRow Horizontal") != std::string::npos)
-            {
-                double coord = 0.0;
-                double height = 0.0;
-                double subrow_origin = 0.0;
-                int num_sites = 0;
-
-                while (std::getline(in, line))
-                {
-                    if (line.find("End") != std::string::npos)
-                        break;
-
-                    std::istringstream iss(line);
-                    std::string token;
-
-                    if (line.find("Coordinate") != std::string::npos)
-                    {
-                        iss >> token >> token >> coord;
-                        die_area.min_y = std::min(die_area.min_y, coord);
-                    }
-                    else if (line.find("Height") != std::string::npos)
-                    {
-                        iss >> token >> token >> height;
-                        die_area.max_y = std::max(die_area.max_y, coord + height);
-                        row_height = height; // Set the row height
-                    }
-                    else if (line.find("SubrowOrigin") != std::string::npos)
-                    {
-                        iss >> token >> token >> subrow_origin >> token >> token >> num_sites;
-                        die_area.min_x = std::min(die_area.min_x, subrow_origin);
-                        die_area.max_x = std::max(die_area.max_x, subrow_origin + num_sites * row_height);
-                    }
-                }
-            }
+            die_area.min_y = std::min(die_area.min_y, row.coordinate);
+            die_area.max_y = std::max(die_area.max_y, row.coordinate + row.height);
+            die_area.min_x = std::min(die_area.min_x, row.subrow_origin);
+            die_area.max_x = std::max(die_area.max_x, row.subrow_origin + row.num_sites * row.site_spacing);
+            row_height = row.height;
         }
 
         if (row_height <= 0.0)
         {
             throw std::runtime_error("Invalid row height in SCL file");
         }
-
-        in.close();
     }
 
     void detailedPlacement()
     {
         std::cout << "Starting greedy legalization process...\n";
 
-        // Calculate number of rows
-        int num_rows = static_cast<int>((die_area.max_y - die_area.min_y) / row_height);
-        std::vector<Row> rows;
-
-        // Initialize rows
-        for (int i = 0; i < num_rows; ++i)
-        {
-            double y_coord = die_area.min_y + i * row_height;
-            rows.emplace_back(y_coord, die_area.max_x - die_area.min_x);
-            rows.back().right_edge = die_area.min_x;
-        }
+        std::vector<SiteRow> rows = buildSiteRows(design);
+        const int num_rows = static_cast<int>(rows.size());
 
         // Sort cells by x-coordinate
-        std::vector<Node *> sortedNodes;
-        for (auto &node : nodes)
-        {
-            if (!node.is_terminal && !node.is_fixed)
-            {
-                sortedNodes.push_back(&node);
-            }
-        }
-        std::sort(sortedNodes.begin(), sortedNodes.end(),
-                  [](const Node *a, const Node *b)
+        std::vector<int> sortedCells = cells.movable;
+        std::sort(sortedCells.begin(), sortedCells.end(),
+                  [this](int a, int b)
                   {
-                      return a->original_x < b->original_x;
+                      return cells.x[a] < cells.x[b];
                   });
 
         // Place each cell
-        for (Node *node : sortedNodes)
+        for (int cell : sortedCells)
         {
+            const double cell_x = cells.x[cell];
+            const double cell_y = cells.y[cell];
+            const double cell_width = cells.width[cell];
+
             // Find best row for this cell
             int best_row = -1;
+            int best_site = 0;
             double min_displacement = std::numeric_limits<double>::max();
-            double best_x = 0;
 
-            // Try each row
-            for (int i = 0; i < num_rows; ++i)
+            // Try rows outward from the cell, in order of vertical distance, until
+            // the vertical move alone costs more than the best row. Ties go to
+            // the lower row, as in a scan over all rows.
+            int above = static_cast<int>(
+                std::lower_bound(rows.begin(), rows.end(), cell_y,
+                                 [](const SiteRow &row, double y)
+                                 {
+                                     return row.y < y;
+                                 }) -
+                rows.begin());
+            int below = above - 1;
+            while (below >= 0 || above < num_rows)
             {
-                // Calculate potential position in this row
-                double potential_x = std::max(die_area.min_x,
-                                              std::max(node->original_x, rows[i].right_edge));
+                int i;
+                if (above >= num_rows ||
+                    (below >= 0 && cell_y - rows[below].y <= rows[above].y - cell_y))
+                {
+                    i = below--;
+                }
+                else
+                {
+                    i = above++;
+                }
 
-                // Check if cell fits in row width
-                if (potential_x + node->width <= die_area.max_x)
+                if (std::abs(rows[i].y - cell_y) > min_displacement)
                 {
-                    double displacement = calculateDisplacement(*node, potential_x, rows[i].y_coordinate);
-                    if (displacement < min_displacement)
-                    {
-                        min_displacement = displacement;
-                        best_row = i;
-                        best_x = potential_x;
-                    }
+                    break;
+                }
+                // Rows without a free span as wide as the cell are skipped at once
+                int sites = rows[i].sitesFor(cell_width);
+                if (rows[i].free.longest() < sites)
+                {
+                    continue;
                 }
-            }
 
-            // If no valid position found, try to place in row with least utilization
-            if (best_row == -1)
-            {
-                double min_utilization = std::numeric_limits<double>::max();
-                for (int i = 0; i < num_rows; ++i)
+                // Nearest free sites to the cell's position in this row
+                int site = rows[i].free.nearest(rows[i].siteAt(cell_x, sites), sites);
+                double displacement = calculateDisplacement(cell, rows[i].siteX(site), rows[i].y);
+                if (displacement < min_displacement ||
+                    (displacement == min_displacement && i < best_row))
                 {
-                    double utilization = (rows[i].right_edge - die_area.min_x) / rows[i].width;
-                    if (utilization < min_utilization &&
-                        rows[i].right_edge + node->width <= die_area.max_x)
-                    {
-                        min_utilization = utilization;
-                        best_row = i;
-                        best_x = rows[i].right_edge;
-                    }
+                    min_displacement = displacement;
+                    best_row = i;
+                    best_site = site;
                 }
             }
 
             // Place the cell
             if (best_row != -1)
             {
-                node->new_x = best_x;
-                node->new_y = rows[best_row].y_coordinate;
-                rows[best_row].right_edge = best_x + node->width;
-                rows[best_row].cells.push_back(node);
+                SiteRow &row = rows[best_row];
+                cells.new_x[cell] = row.siteX(best_site);
+                cells.new_y[cell] = row.y;
+                row.free.occupy(best_site, best_site + row.sitesFor(cell_width));
             }
             else
             {
-                std::cerr << "Warning: Could not place cell " << node->name << std::endl;
+                std::cerr << "Warning: Could not place cell " << design.nodes[cell].name << std::endl;
             }
         }
+    }
 
-        // Calculate final displacement metrics
-        total_displacement = 0;
-        max_displacement = 0;
+    void abacusPlacement()
+    {
+        std::cout << "Starting Abacus legalization process...\n";
 
-        for (const Node *node : sortedNodes)
+        // Every free span of a subrow is a row of its own for Abacus
+        std::vector<AbacusRow> rows;
+        for (const SiteRow &row : buildSiteRows(design))
         {
-            double displacement = calculateDisplacement(*node, node->new_x, node->new_y);
-            total_displacement += displacement;
-            max_displacement = std::max(max_displacement, displacement);
+            for (const auto &span : row.free.getSpans())
+            {
+                rows.push_back({row.y, row.siteX(span.first), row.siteX(span.second), row.spacing});
+            }
+        }
+
+        const std::vector<int> &movable = cells.movable;
+        std::vector<double> new_x, new_y;
+        RegionLegalizer legalizer(std::move(rows), options.row_window, options.regions, options.threads);
+        for (int k : legalizer.legalize(cells.gatherMovable(cells.x), cells.gatherMovable(cells.y),
+                                        cells.gatherMovable(cells.width), new_x, new_y))
+        {
+            std::cerr << "Warning: Could not place cell " << design.nodes[movable[k]].name << std::endl;
+        }
+        if (options.regions > 1)
+        {
+            std::cout << "Stripes: " << legalizer.getStripes()
+                      << ", boundary windows improved: " << legalizer.getReconciled() << std::endl;
+        }
+        for (std::size_t k = 0; k < movable.size(); ++k)
+        {
+            cells.new_x[movable[k]] = new_x[k];
+            cells.new_y[movable[k]] = new_y[k];
         }
     }
 
+    // Wirelength-driven swaps, reordering and shifts on the legal placement
+    void optimizePlacement()
+    {
+        DetailedPlacer placer(design, cells, options.displacement_weight, options.threads);
+        placer.run(options.passes);
+        std::cout << "Detailed placement: " << placer.getSwaps() << " swaps, " << placer.getReorders()
+                  << " reorders, " << placer.getShifts() << " shifts" << std::endl;
+        std::cout << "Detailed placement time: " << placer.getSeconds() << " s" << std::endl;
+    }
+
     void calculateDisplacement()
     {
         total_displacement = 0.0;
         max_displacement = 0.0;
 
-        for (const auto &node : nodes)
+        for (int cell : cells.movable)
         {
-            if (node.is_terminal || node.is_fixed)
-                continue;
-
-            double dx = node.new_x - node.original_x;
-            double dy = node.new_y - node.original_y;
-            double displacement = std::abs(dx) + std::abs(dy); // Manhattan distance
+            double displacement = calculateDisplacement(cell, cells.new_x[cell], cells.new_y[cell]); // Manhattan distance
 
             total_displacement += displacement;
             max_displacement = std::max(max_displacement, displacement);
         }
     }
 
-    double calculateOverlap(const Node &n1, const Node &n2)
+    // Overlap between movable cells, which is 0 for a legal placement
+    double calculateTotalOverlap()
     {
-        double x_overlap = std::min(n1.new_x + n1.width, n2.new_x + n2.width) -
-                           std::max(n1.new_x, n2.new_x);
-        double y_overlap = std::min(n1.new_y + n1.height, n2.new_y + n2.height) -
-                           std::max(n1.new_y, n2.new_y);
-
-        if (x_overlap > 0 && y_overlap > 0)
+        OverlapChecker checker(row_height, options.threads, options.list_overlaps);
+        double total_overlap = checker.check(cells.gatherMovable(cells.new_x), cells.gatherMovable(cells.new_y),
+                                             cells.gatherMovable(cells.width), cells.gatherMovable(cells.height));
+        for (const OverlapPair &pair : checker.getPairs())
         {
-            return x_overlap * y_overlap;
+            std::cout << "Overlap: " << design.nodes[cells.movable[pair.a]].name << " "
+                      << design.nodes[cells.movable[pair.b]].name
+                      << " " << pair.area << std::endl;
         }
-        return 0.0;
+        std::cout << "Overlap check time: " << checker.getSeconds() << " s" << std::endl;
+        return total_overlap;
     }
 
-    double calculateTotalOverlap()
+    // HPWL before and after legalization, from the parsed nets
+    void reportWirelength()
     {
-        double total_overlap = 0.0;
-        for (size_t i = 0; i < nodes.size(); ++i)
+        HpwlEvaluator hpwl(design.nets, cells, options.threads);
+        double input_hpwl = hpwl.evaluate(false);
+        double output_hpwl = hpwl.evaluate(true);
+        std::cout << "HPWL: " << input_hpwl << " -> " << output_hpwl;
+        if (input_hpwl > 0)
         {
-            if (nodes[i].is_terminal || nodes[i].is_fixed)
-                continue;
-
-            for (size_t j = i + 1; j < nodes.size(); ++j)
-            {
-                if (nodes[j].is_terminal || nodes[j].is_fixed)
-                    continue;
-                total_overlap += calculateOverlap(nodes[i], nodes[j]);
-            }
+            std::cout << " (" << std::showpos << (output_hpwl / input_hpwl - 1) * 100 << std::noshowpos << "%)";
         }
-        return total_overlap;
+        std::cout << std::endl;
+        std::cout << "HPWL evaluation time: " << hpwl.getSeconds() << " s" << std::endl;
     }
 
+    // Renders the input or legalized placement to <case>_input_placement and
+    // <case>_output_placement .png and .svg files in the output directory
     void generateVisualization(bool use_new_coordinates = false)
     {
         std::string case_name = input_dir.stem().string();
-        std::string plot_file = (output_dir / (case_name + (use_new_coordinates ? "_output_plot.gp" : "_input_plot.gp"))).string();
-        std::ofstream out(plot_file);
-
-        // Set canvas size and white background
-        out << "set terminal png enhanced size 800,800 background rgb 'white'\n";
-        out << "set output '" << case_name
-            << (use_new_coordinates ? "_output_placement.png" : "_input_placement.png") << "'\n";
-
-        // Clean up the plot
-        out << "unset title\n";
-        out << "unset key\n";
-        out << "set border 1\n";
-        out << "unset xtics\n";
-        out << "unset ytics\n";
-
-        // Calculate bounds
-        double min_x = std::numeric_limits<double>::max();
-        double max_x = std::numeric_limits<double>::lowest();
-        double min_y = std::numeric_limits<double>::max();
-        double max_y = std::numeric_limits<double>::lowest();
-
-        for (const auto &node : nodes)
-        {
-            double x = use_new_coordinates ? node.new_x : node.original_x;
-            double y = use_new_coordinates ? node.new_y : node.original_y;
+        std::string image = (output_dir / (case_name + (use_new_coordinates ? "_output_placement" : "_input_placement"))).string();
 
-            min_x = std::min(min_x, x);
-            max_x = std::max(max_x, x + node.width);
-            min_y = std::min(min_y, y);
-            max_y = std::max(max_y, y + node.height);
-        }
-
-        // Calculate ranges with smaller padding
-        double width = max_x - min_x;
-        double height = max_y - min_y;
-        double max_dim = std::max(width, height);
-        double padding = max_dim * 0.3; // Reduce padding even more
-
-        // Center the plot
-        double center_x = (min_x + max_x) / 2.0;
-        double center_y = (min_y + max_y) / 2.0;
-
-        // Set ranges
-        double half_range = (max_dim + padding) / 2.0;
-        out << "set xrange [" << (center_x - half_range) << ":" << (center_x + half_range) << "]\n";
-        out << "set yrange [" << (center_y - half_range) << ":" << (center_y + half_range) << "]\n";
-
-        // Ensure square aspect ratio
-        out << "set size square\n";
-
-        // Draw nodes with empty fill
-        int obj_count = 1;
-        for (const auto &node : nodes)
-        {
-            double x = use_new_coordinates ? node.new_x : node.original_x;
-            double y = use_new_coordinates ? node.new_y : node.original_y;
-
-            out << "set object " << obj_count++ << " rectangle from "
-                << x << "," << y << " to "
-                << (x + node.width) << "," << (y + node.height)
-                << " fc rgb '#FFFFFF' fs empty border rgb '#800080' lw 1\n";
-        }
-
-        // Minimal margins
-        out << "set lmargin 0\n";
-        out << "set rmargin 0\n";
-        out << "set tmargin 0\n";
-        out << "set bmargin 0\n";
-
-        out << "plot NaN notitle\n";
-        out.close();
-
-        // Execute gnuplot
-        std::string gnuplot_cmd = "gnuplot \"" + plot_file + "\"";
-        int result = system(gnuplot_cmd.c_str());
-        if (result != 0)
-        {
-            std::cerr << "Warning: Gnuplot command failed for " << case_name << std::endl;
-        }
+        PlacementRenderer renderer;
+        renderer.render(use_new_coordinates ? cells.new_x : cells.x, use_new_coordinates ? cells.new_y : cells.y,
+                        cells.width, cells.height);
+        renderer.writePng(image + ".png");
+        renderer.writeSvg(image + ".svg");
     }
 
 public:
-    CircuitLegalizer(const std::string &input, const std::string &output)
-        : input_dir(input), output_dir(output)
+    CircuitLegalizer(const std::string &input, const std::string &output,
+                     const LegalizerOptions &options = LegalizerOptions())
+        : options(options), input_dir(input), output_dir(output)
     {
         input_name = input_dir.stem().string();
         output_name = output_dir.stem().string();
@@ -666,42 +314,90 @@ public:
         try
         {
             std::cout << "Processing input files..." << std::endl;
-            processNodesFile();
-            processPlFile();
-            processSclFile();
-
-            std::cout << "\nGenerating initial visualization..." << std::endl;
-            generateVisualization(false);
+            readInputFiles();
+
+            // .nodes does not depend on the placement and is written while
+            // the legalizer runs; the rest once it is done, all in parallel
+            BookshelfWriter writer(design, output_dir.string(), output_name);
+            std::vector<std::future<void>> outputs;
+            outputs.push_back(std::async(std::launch::async, [&writer]
+                                         { writer.writeNodes(); }));
+
+            // The plots only read the cells, so they are drawn while the
+            // legalizer and the output writers run
+            std::future<void> input_plot, output_plot;
+            if (options.plots)
+            {
+                std::cout << "\nGenerating initial visualization..." << std::endl;
+                input_plot = std::async(std::launch::async, [this]
+                                        { generateVisualization(false); });
+            }
 
             std::cout << "\nPerforming detailed placement..." << std::endl;
-            detailedPlacement();
+            auto started = std::chrono::steady_clock::now();
+            if (options.engine == "abacus")
+            {
+                abacusPlacement();
+            }
+            else
+            {
+                detailedPlacement();
+            }
+            std::cout << "Legalization time: "
+                      << std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count()
+                      << " s" << std::endl;
+            if (options.passes > 0)
+            {
+                optimizePlacement();
+            }
 
             calculateDisplacement();
             std::cout << "\nPlacement results:" << std::endl;
             std::cout << "Total displacement: " << total_displacement << std::endl;
             std::cout << "Maximum displacement: " << max_displacement << std::endl;
-            std::cout << "Final overlap: " << calculateTotalOverlap() << std::endl;
+            double overlap = calculateTotalOverlap();
+            std::cout << "Final overlap: " << overlap << std::endl;
+            reportWirelength();
 
-            std::cout << "\nGenerating final visualization..." << std::endl;
-            generateVisualization(true);
+            if (options.plots)
+            {
+                input_plot.get();
+                std::cout << "\nGenerating final visualization..." << std::endl;
+                output_plot = std::async(std::launch::async, [this]
+                                         { generateVisualization(true); });
+            }
 
             std::cout << "\nWriting output files..." << std::endl;
-            processPlFile(); // Write final positions
-            processAuxFile();
-
-            // Copy unchanged files
-            fs::copy_file(
-                input_dir / (input_name + ".nets"),
-                output_dir / (output_name + ".nets"),
-                fs::copy_options::overwrite_existing);
-            fs::copy_file(
-                input_dir / (input_name + ".wts"),
-                output_dir / (output_name + ".wts"),
-                fs::copy_options::overwrite_existing);
-            fs::copy_file(
-                input_dir / (input_name + ".scl"),
-                output_dir / (output_name + ".scl"),
-                fs::copy_options::overwrite_existing);
+            started = std::chrono::steady_clock::now();
+            outputs.push_back(std::async(std::launch::async, [&]
+                                         { writer.writePl(cells.new_x, cells.new_y); }));
+            outputs.push_back(std::async(std::launch::async, [&writer]
+                                         { writer.writeAux(); }));
+
+            // Unchanged files are linked rather than copied where possible
+            for (const char *extension : {".nets", ".wts", ".scl"})
+            {
+                std::string source = (input_dir / (input_name + extension)).string();
+                outputs.push_back(std::async(std::launch::async, [&writer, source, extension]
+                                             { writer.linkUnchanged(source, extension); }));
+            }
+
+            // Let every writer finish before the first failure is rethrown
+            for (auto &output : outputs)
+            {
+                output.wait();
+            }
+            for (auto &output : outputs)
+            {
+                output.get();
+            }
+            std::cout << "Output write time: "
+                      << std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count()
+                      << " s" << std::endl;
+            if (options.plots)
+            {
+                output_plot.get();
+            }
 
             std::cout << "All processing completed successfully!" << std::endl;
         }
@@ -714,15 +410,63 @@ public:
 
 int main(int argc, char *argv[])
 {
-    if (argc != 3)
+    LegalizerOptions options;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-m" && i + 1 < argc)
+        {
+            options.engine = argv[++i];
+            if (options.engine != "greedy" && options.engine != "abacus")
+            {
+                std::cerr << "Unknown engine: " << options.engine << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "-w" && i + 1 < argc)
+        {
+            options.row_window = std::stoi(argv[++i]);
+        }
+        else if (arg == "-r" && i + 1 < argc)
+        {
+            options.regions = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "-j" && i + 1 < argc)
+        {
+            options.threads = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "-d" && i + 1 < argc)
+        {
+            options.passes = std::max(0, std::stoi(argv[++i]));
+        }
+        else if (arg == "-k" && i + 1 < argc)
+        {
+            options.displacement_weight = std::max(0.0, std::stod(argv[++i]));
+        }
+        else if (arg == "-n")
+        {
+            options.plots = false;
+        }
+        else if (arg == "-l")
+        {
+            options.list_overlaps = true;
+        }
+        else
+        {
+            paths.push_back(arg);
+        }
+    }
+
+    if (paths.size() != 2)
     {
-        std::cerr << "Usage: " << argv[0] << " INPUT_DIR OUTPUT_DIR" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " [-m greedy|abacus] [-w ROWS] [-r REGIONS] [-j THREADS] [-d PASSES] [-k WEIGHT] [-l] [-n] INPUT_DIR OUTPUT_DIR" << std::endl;
         return 1;
     }
 
     try
     {
-        CircuitLegalizer legalizer(argv[1], argv[2]);
+        CircuitLegalizer legalizer(paths[0], paths[1], options);
         legalizer.process();
         return 0;
     }
@@ -0,0 +1,165 @@
+#include "abacus.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+AbacusLegalizer::AbacusLegalizer(std::vector<AbacusRow> rows, int row_window)
+    : rows(std::move(rows)), row_window(std::max(1, row_window))
+{
+}
+
+// Site-aligned left edge nearest to x for a cluster of `width`
+double AbacusLegalizer::clampX(int row, double x, double width) const
+{
+    const AbacusRow &r = rows[row];
+    double aligned = r.min_x + std::round((x - r.min_x) / r.site) * r.site;
+    return std::max(r.min_x, std::min(aligned, r.max_x - width));
+}
+
+// Width rounded up to whole sites, so abutting cells stay on the grid
+double AbacusLegalizer::siteWidth(int row, double width) const
+{
+    return std::ceil(width / rows[row].site - 1e-9) * rows[row].site;
+}
+
+// Position the cell would get as the last cell of `row`, found by collapsing
+// a copy of the clusters it would merge with
+bool AbacusLegalizer::trial(int row, double x, double width, double &cell_x) const
+{
+    const RowState &state = states[row];
+    width = siteWidth(row, width);
+    if (state.used + width > rows[row].max_x - rows[row].min_x)
+    {
+        return false;
+    }
+
+    double e = 1.0;
+    double q = x;
+    double w = width;
+    double left = clampX(row, q / e, w);
+    for (int k = static_cast<int>(state.clusters.size()) - 1;
+         k >= 0 && state.clusters[k].x + state.clusters[k].w > left; --k)
+    {
+        const Cluster &previous = state.clusters[k];
+        q = previous.q + q - e * previous.w;
+        e += previous.e;
+        w += previous.w;
+        left = clampX(row, q / e, w);
+    }
+    cell_x = left + w - width;
+    return true;
+}
+
+void AbacusLegalizer::commit(int row, int cell, double x, double width)
+{
+    RowState &state = states[row];
+    width = siteWidth(row, width);
+    state.clusters.push_back({clampX(row, x, width), 1.0, x, width,
+                              static_cast<int>(state.cells.size())});
+    state.cells.push_back(cell);
+    state.used += width;
+
+    // Merge with the left neighbour while the two overlap
+    while (state.clusters.size() > 1)
+    {
+        Cluster &last = state.clusters.back();
+        Cluster &previous = state.clusters[state.clusters.size() - 2];
+        if (previous.x + previous.w <= last.x)
+        {
+            break;
+        }
+        previous.q += last.q - last.e * previous.w;
+        previous.e += last.e;
+        previous.w += last.w;
+        previous.x = clampX(row, previous.q / previous.e, previous.w);
+        state.clusters.pop_back();
+    }
+}
+
+std::vector<int> AbacusLegalizer::legalize(const std::vector<double> &x, const std::vector<double> &y,
+                                           const std::vector<double> &width,
+                                           std::vector<double> &new_x, std::vector<double> &new_y)
+{
+    states.assign(rows.size(), RowState());
+    new_x = x;
+    new_y = y;
+
+    std::vector<int> order(x.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+                     { return x[a] < x[b]; });
+
+    const int num_rows = static_cast<int>(rows.size());
+    std::vector<int> unplaced;
+    for (int cell : order)
+    {
+        // Rows below and above the cell, visited in order of vertical distance
+        int above = static_cast<int>(
+            std::lower_bound(rows.begin(), rows.end(), y[cell],
+                             [](const AbacusRow &row, double value)
+                             { return row.y < value; }) -
+            rows.begin());
+        int below = above - 1;
+
+        int best_row = -1;
+        double best_cost = std::numeric_limits<double>::max();
+        int tried = 0;
+        while (below >= 0 || above < num_rows)
+        {
+            int row;
+            if (above >= num_rows || (below >= 0 && y[cell] - rows[below].y <= rows[above].y - y[cell]))
+            {
+                row = below--;
+            }
+            else
+            {
+                row = above++;
+            }
+
+            double dy = std::abs(rows[row].y - y[cell]);
+            if (dy >= best_cost || (tried >= row_window && best_row != -1))
+            {
+                break;
+            }
+            ++tried;
+
+            double cell_x;
+            if (trial(row, x[cell], width[cell], cell_x))
+            {
+                double cost = std::abs(cell_x - x[cell]) + dy;
+                if (cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_row = row;
+                }
+            }
+        }
+
+        if (best_row == -1)
+        {
+            unplaced.push_back(cell);
+            continue;
+        }
+        commit(best_row, cell, x[cell], width[cell]);
+        new_y[cell] = rows[best_row].y;
+    }
+
+    // Cells take their positions from the final clusters
+    for (int row = 0; row < num_rows; ++row)
+    {
+        const RowState &state = states[row];
+        for (std::size_t k = 0; k < state.clusters.size(); ++k)
+        {
+            std::size_t end = k + 1 < state.clusters.size() ? state.clusters[k + 1].first : state.cells.size();
+            double left = state.clusters[k].x;
+            for (std::size_t i = state.clusters[k].first; i < end; ++i)
+            {
+                new_x[state.cells[i]] = left;
+                left += siteWidth(row, width[state.cells[i]]);
+            }
+        }
+    }
+    return unplaced;
+}
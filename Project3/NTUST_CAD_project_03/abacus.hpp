@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+
+// One placement row, or a free span of one: cells sit at y with their
+// extent inside [min_x, max_x], at min_x plus a multiple of `site`
+struct AbacusRow
+{
+    double y;
+    double min_x;
+    double max_x;
+    double site;
+};
+
+// Abacus legalization (Spindler, Schlichtmann and Johannes, ISPD 2008).
+// Cells are taken in order of their desired x and appended to the row where
+// they move least. Each row keeps its cells as clusters of abutting cells; a
+// cluster sits at the mean of its cells' desired positions, the quadratic
+// optimum rounded to the nearest site, and merges with its left neighbour when the two overlap, so cells
+// already placed shift left or right to make room.
+//
+// Rows are tried outward from the one nearest to the cell. The search stops
+// once the vertical move alone costs more than the best row so far, or once
+// `row_window` rows have been tried and one of them fits the cell; a cell
+// only looks further when every row in its window is full.
+class AbacusLegalizer
+{
+public:
+    // Rows must be sorted by y
+    AbacusLegalizer(std::vector<AbacusRow> rows, int row_window);
+
+    // Places the cells given by their desired lower-left corner and width and
+    // writes the legal corners to new_x/new_y. Returns the cells that fit in
+    // no row; those keep their desired position.
+    std::vector<int> legalize(const std::vector<double> &x, const std::vector<double> &y,
+                              const std::vector<double> &width,
+                              std::vector<double> &new_x, std::vector<double> &new_y);
+
+private:
+    struct Cluster
+    {
+        double x; // Left edge
+        double e; // Number of cells (all weights are 1)
+        double q; // Sum of desired x minus offset within the cluster
+        double w; // Total width
+        int first; // First cell, as an index into RowState::cells
+    };
+
+    struct RowState
+    {
+        std::vector<int> cells; // In placement order, left to right
+        std::vector<Cluster> clusters;
+        double used = 0.0;
+    };
+
+    std::vector<AbacusRow> rows;
+    std::vector<RowState> states;
+    int row_window;
+
+    double clampX(int row, double x, double width) const;
+    double siteWidth(int row, double width) const;
+    bool trial(int row, double x, double width, double &cell_x) const;
+    void commit(int row, int cell, double x, double width);
+};
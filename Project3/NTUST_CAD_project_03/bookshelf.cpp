@@ -0,0 +1,480 @@
+#include "bookshelf.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+
+namespace
+{
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y)
+                      { return std::tolower(static_cast<unsigned char>(x)) ==
+                               std::tolower(static_cast<unsigned char>(y)); });
+}
+
+// Lines of a mapped file, each split into whitespace-separated tokens
+class LineReader
+{
+public:
+    LineReader(const MappedFile &file, const std::string &filename)
+        : cursor(file.begin()), limit(file.end()), filename(filename) {}
+
+    // Moves to the next line; false at the end of the file
+    bool next()
+    {
+        if (cursor >= limit)
+        {
+            return false;
+        }
+        const char *end = std::find(cursor, limit, '\n');
+        text = std::string_view(cursor, end - cursor);
+        at = text.data();
+        cursor = end < limit ? end + 1 : end;
+        ++line_number;
+        return true;
+    }
+
+    std::string_view line() const { return text; }
+    long long lineNumber() const { return line_number; }
+
+    bool contains(std::string_view word) const { return text.find(word) != std::string_view::npos; }
+
+    // Next token of the line, empty at its end
+    std::string_view token()
+    {
+        const char *stop = text.data() + text.size();
+        while (at < stop && isSpace(*at))
+        {
+            ++at;
+        }
+        const char *from = at;
+        while (at < stop && !isSpace(*at))
+        {
+            ++at;
+        }
+        return std::string_view(from, at - from);
+    }
+
+    // Next token as a number; false when it is missing or not a number
+    template <typename T>
+    bool number(T &value)
+    {
+        std::string_view word = token();
+        if (!word.empty() && word[0] == '+')
+        {
+            word.remove_prefix(1);
+        }
+        auto [end, error] = std::from_chars(word.data(), word.data() + word.size(), value);
+        return !word.empty() && error == std::errc() && end == word.data() + word.size();
+    }
+
+    template <typename T>
+    T expect()
+    {
+        T value{};
+        if (!number(value))
+        {
+            fail("expected a number");
+        }
+        return value;
+    }
+
+    [[noreturn]] void fail(const std::string &message) const
+    {
+        throw std::runtime_error(filename + ":" + std::to_string(line_number) + ": " + message);
+    }
+
+private:
+    const char *cursor;
+    const char *limit;
+    const std::string &filename;
+    std::string_view text;
+    const char *at = nullptr;
+    long long line_number = 0;
+};
+
+// Value of a "Key : value" line, whose key was already taken
+template <typename T>
+T valueAfterColon(LineReader &lines)
+{
+    std::string_view word = lines.token();
+    if (word != ":")
+    {
+        lines.fail("expected ':'");
+    }
+    return lines.expect<T>();
+}
+
+void parseNodes(const MappedFile &file, const std::string &filename, BookshelfDesign &design)
+{
+    LineReader lines(file, filename);
+    while (lines.next())
+    {
+        std::string_view line = lines.line();
+        if (lines.contains("NumNodes"))
+        {
+            lines.token();
+            int count = 0;
+            if (lines.token() == ":" && lines.number(count) && count > 0)
+            {
+                design.nodes.reserve(count);
+                design.names.reserve(count, 8 * static_cast<std::size_t>(count));
+            }
+            design.nodes_header.emplace_back(line);
+            continue;
+        }
+        if (line.empty() || line[0] == '#' || lines.contains("NumTerminals") || lines.contains("UCLA"))
+        {
+            design.nodes_header.emplace_back(line);
+            continue;
+        }
+
+        std::string_view name = lines.token();
+        BookshelfNode node;
+        if (name.empty() || !lines.number(node.width) || !lines.number(node.height))
+        {
+            design.nodes_header.emplace_back(line);
+            continue;
+        }
+        if (design.names.intern(name) != static_cast<int>(design.nodes.size()))
+        {
+            lines.fail("duplicate node " + std::string(name));
+        }
+        node.name = name;
+        node.is_terminal = lines.token() == "terminal";
+        design.nodes.push_back(std::move(node));
+    }
+}
+
+struct PlRecord
+{
+    std::string_view name;
+    BookshelfPlacement placement;
+};
+
+// Lines up to the banner are the header; lines that do not parse are skipped
+void parsePl(const MappedFile &file, const std::string &filename, BookshelfDesign &design,
+             std::vector<PlRecord> &records)
+{
+    LineReader lines(file, filename);
+    while (lines.next())
+    {
+        design.pl_header.emplace_back(lines.line());
+        if (lines.contains("UCLA pl 1.0"))
+        {
+            break;
+        }
+    }
+
+    while (lines.next())
+    {
+        std::string_view line = lines.line();
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        PlRecord record;
+        record.name = lines.token();
+        if (record.name.empty() || !lines.number(record.placement.x) || !lines.number(record.placement.y))
+        {
+            continue;
+        }
+        std::string_view orientation = lines.token();
+        if (!orientation.empty() && orientation[0] == ':')
+        {
+            orientation.remove_prefix(1);
+        }
+        if (orientation.empty())
+        {
+            orientation = lines.token();
+        }
+        if (orientation.empty())
+        {
+            continue;
+        }
+        record.placement.orientation = orientation;
+        record.placement.is_fixed = lines.token() == "/FIXED";
+        records.push_back(record);
+    }
+}
+
+void parseScl(const MappedFile &file, const std::string &filename, BookshelfDesign &design)
+{
+    LineReader lines(file, filename);
+    BookshelfRow *row = nullptr;
+    while (lines.next())
+    {
+        std::string_view key = lines.token();
+        if (key.empty() || key[0] == '#')
+        {
+            continue;
+        }
+        if (key == "NumRows")
+        {
+            design.rows.reserve(std::max(0, valueAfterColon<int>(lines)));
+        }
+        else if (key == "CoreRow")
+        {
+            design.rows.emplace_back();
+            row = &design.rows.back();
+        }
+        else if (key == "End")
+        {
+            row = nullptr;
+        }
+        else if (row == nullptr)
+        {
+            continue;
+        }
+        else if (key == "Coordinate")
+        {
+            row->coordinate = valueAfterColon<double>(lines);
+        }
+        else if (key == "Height")
+        {
+            row->height = valueAfterColon<double>(lines);
+        }
+        else if (key == "Sitewidth")
+        {
+            row->site_width = valueAfterColon<double>(lines);
+        }
+        else if (key == "Sitespacing")
+        {
+            row->site_spacing = valueAfterColon<double>(lines);
+        }
+        else if (key == "SubrowOrigin")
+        {
+            row->subrow_origin = valueAfterColon<double>(lines);
+            if (!equalsIgnoreCase(lines.token(), "NumSites"))
+            {
+                lines.fail("expected NumSites");
+            }
+            row->num_sites = valueAfterColon<int>(lines);
+        }
+    }
+}
+
+struct NetPin
+{
+    std::string_view name;
+    char direction;
+    double dx, dy;
+    long long line;
+};
+
+// A net holds the pins listed below its NetDegree line; `mismatched`
+// counts nets whose declared degree differs from that
+void parseNets(const MappedFile &file, const std::string &filename, BookshelfDesign &design,
+               std::vector<NetPin> &pins, int &mismatched)
+{
+    BookshelfNets &nets = design.nets;
+    LineReader lines(file, filename);
+    int declared = -1; // Degree of the current net, -1 before the first
+    auto close_net = [&]
+    {
+        if (declared < 0)
+        {
+            return;
+        }
+        int listed = static_cast<int>(pins.size()) - nets.net_start.back();
+        mismatched += listed != declared;
+        nets.net_start.push_back(static_cast<int>(pins.size()));
+    };
+
+    while (lines.next())
+    {
+        std::string_view first = lines.token();
+        if (first.empty() || first[0] == '#' || first == "UCLA")
+        {
+            continue;
+        }
+
+        if (first == "NumNets")
+        {
+            nets.net_start.reserve(valueAfterColon<int>(lines) + 1);
+        }
+        else if (first == "NumPins")
+        {
+            int count = valueAfterColon<int>(lines);
+            pins.reserve(count);
+            nets.pin_node.reserve(count);
+            nets.pin_direction.reserve(count);
+            nets.pin_dx.reserve(count);
+            nets.pin_dy.reserve(count);
+        }
+        else if (first == "NetDegree")
+        {
+            close_net();
+            declared = valueAfterColon<int>(lines);
+            if (declared < 0)
+            {
+                lines.fail("negative net degree");
+            }
+        }
+        else
+        {
+            if (declared < 0)
+            {
+                lines.fail("pin before the first NetDegree");
+            }
+            NetPin pin{first, 0, 0.0, 0.0, lines.lineNumber()};
+            std::string_view word = lines.token();
+            if (!word.empty() && word != ":")
+            {
+                pin.direction = word[0];
+                word = lines.token();
+            }
+            if (word == ":")
+            {
+                pin.dx = lines.expect<double>();
+                pin.dy = lines.expect<double>();
+            }
+            pins.push_back(pin);
+        }
+    }
+    close_net();
+}
+
+void parseWts(const MappedFile &file, const std::string &filename,
+              std::vector<std::pair<std::string_view, double>> &records)
+{
+    LineReader lines(file, filename);
+    while (lines.next())
+    {
+        std::string_view name = lines.token();
+        if (name.empty() || name[0] == '#' || name == "UCLA")
+        {
+            continue;
+        }
+        records.emplace_back(name, lines.expect<double>());
+    }
+}
+
+// The readers below parse on their own and wait for .nodes only to
+// resolve the names they collected
+
+void readPl(const MappedFile &file, const std::string &filename, BookshelfDesign &design,
+            std::shared_future<void> nodes_ready)
+{
+    std::vector<PlRecord> records;
+    parsePl(file, filename, design, records);
+    nodes_ready.get();
+    design.placements.resize(design.nodes.size());
+    for (const PlRecord &record : records)
+    {
+        int index = design.names.find(record.name);
+        if (index != NameTable::npos)
+        {
+            design.placements[index] = record.placement;
+        }
+    }
+}
+
+void readNets(const MappedFile &file, const std::string &filename, BookshelfDesign &design,
+              std::shared_future<void> nodes_ready, int &mismatched)
+{
+    std::vector<NetPin> pins;
+    parseNets(file, filename, design, pins, mismatched);
+    nodes_ready.get();
+    BookshelfNets &nets = design.nets;
+    for (const NetPin &pin : pins)
+    {
+        int index = design.names.find(pin.name);
+        if (index == NameTable::npos)
+        {
+            throw std::runtime_error(filename + ":" + std::to_string(pin.line) +
+                                     ": unknown node " + std::string(pin.name));
+        }
+        nets.pin_node.push_back(index);
+        nets.pin_direction.push_back(pin.direction);
+        nets.pin_dx.push_back(pin.dx);
+        nets.pin_dy.push_back(pin.dy);
+    }
+}
+
+// Weights of names that are not nodes (net weights in some suites) are ignored
+void readWts(const MappedFile &file, const std::string &filename, BookshelfDesign &design,
+             std::shared_future<void> nodes_ready)
+{
+    std::vector<std::pair<std::string_view, double>> records;
+    parseWts(file, filename, records);
+    nodes_ready.get();
+    design.weights.assign(design.nodes.size(), 1.0);
+    for (const auto &[name, weight] : records)
+    {
+        int index = design.names.find(name);
+        if (index != NameTable::npos)
+        {
+            design.weights[index] = weight;
+        }
+    }
+}
+
+} // namespace
+
+void BookshelfReader::read(const std::string &dir, const std::string &name, BookshelfDesign &design)
+{
+    auto started = std::chrono::steady_clock::now();
+    design = BookshelfDesign();
+    const std::string base = dir + "/" + name;
+    const std::string aux_name = base + ".aux", nodes_name = base + ".nodes", pl_name = base + ".pl", scl_name = base + ".scl",
+                      nets_name = base + ".nets", wts_name = base + ".wts";
+    MappedFile aux_file(aux_name), nodes_file(nodes_name), pl_file(pl_name), scl_file(scl_name), nets_file(nets_name),
+        wts_file(wts_name);
+
+    int mismatched_nets = 0;
+    std::shared_future<void> nodes_ready =
+        std::async(std::launch::async, parseNodes, std::cref(nodes_file), std::cref(nodes_name),
+                   std::ref(design))
+            .share();
+    std::future<void> tasks[] = {
+        std::async(std::launch::async, parseScl, std::cref(scl_file), std::cref(scl_name), std::ref(design)),
+        std::async(std::launch::async, readPl, std::cref(pl_file), std::cref(pl_name), std::ref(design),
+                   nodes_ready),
+        std::async(std::launch::async, readNets, std::cref(nets_file), std::cref(nets_name),
+                   std::ref(design), nodes_ready, std::ref(mismatched_nets)),
+        std::async(std::launch::async, readWts, std::cref(wts_file), std::cref(wts_name),
+                   std::ref(design), nodes_ready)};
+
+    // The .aux file is a line or two, split here while the others parse
+    std::string_view aux(aux_file.begin(), aux_file.size());
+    while (!aux.empty())
+    {
+        std::size_t end = std::min(aux.find('\n'), aux.size());
+        design.aux_lines.emplace_back(aux.substr(0, end));
+        aux.remove_prefix(std::min(end + 1, aux.size()));
+    }
+
+    // Let every task finish before the first failure is rethrown
+    for (auto &task : tasks)
+    {
+        task.wait();
+    }
+    nodes_ready.get();
+    for (auto &task : tasks)
+    {
+        task.get();
+    }
+    if (mismatched_nets > 0)
+    {
+        std::cerr << "Warning: " << nets_name << " has " << mismatched_nets
+                  << " nets whose NetDegree differs from their pin list" << std::endl;
+    }
+
+    bytes = aux_file.size() + nodes_file.size() + pl_file.size() + scl_file.size() + nets_file.size() + wts_file.size();
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "name_table.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct BookshelfNode
+{
+    std::string name;
+    double width = 0.0;
+    double height = 0.0;
+    bool is_terminal = false;
+};
+
+// Position from .pl; nodes the file does not list stay at the origin
+struct BookshelfPlacement
+{
+    double x = 0.0;
+    double y = 0.0;
+    std::string orientation = "N";
+    bool is_fixed = false;
+};
+
+struct BookshelfRow
+{
+    double coordinate = 0.0;
+    double height = 0.0;
+    double site_width = 0.0;
+    double site_spacing = 0.0;
+    double subrow_origin = 0.0;
+    int num_sites = 0;
+};
+
+// Nets in compressed form: the pins of net k are [net_start[k], net_start[k + 1])
+struct BookshelfNets
+{
+    std::vector<int> net_start{0};
+    std::vector<int> pin_node;
+    std::vector<char> pin_direction; // 'I', 'O', 'B', or 0 when not given
+    std::vector<double> pin_dx;      // Offset from the node centre
+    std::vector<double> pin_dy;
+
+    int size() const { return static_cast<int>(net_start.size()) - 1; }
+};
+
+struct BookshelfDesign
+{
+    std::vector<BookshelfNode> nodes;
+    NameTable names;                      // Node name -> index into nodes
+    std::vector<BookshelfPlacement> placements; // Indexed like nodes
+    std::vector<BookshelfRow> rows;
+    BookshelfNets nets;
+    std::vector<double> weights;          // Per node from .wts, 1 when not listed
+
+    // Lines of .nodes that are not nodes (banner, comments, counts), the
+    // lines of .pl up to its banner and all of .aux, kept to write the files
+    // back
+    std::vector<std::string> nodes_header;
+    std::vector<std::string> pl_header;
+    std::vector<std::string> aux_lines;
+};
+
+// Reader for the GSRC Bookshelf files of one design: <dir>/<name>.aux,
+// .nodes, .pl, .scl, .nets and .wts. Every file is memory-mapped and tokenised in
+// place with std::from_chars; containers are sized from the NumNodes,
+// NumNets, NumPins and NumRows headers. The five files are parsed on their
+// own threads; .pl, .nets and .wts wait for .nodes only to resolve names.
+// Malformed input throws runtime_error naming the file and line.
+class BookshelfReader
+{
+public:
+    void read(const std::string &dir, const std::string &name, BookshelfDesign &design);
+
+    std::size_t getBytes() const { return bytes; }
+    double getSeconds() const { return seconds; }
+    double getThroughput() const { return seconds > 0 ? bytes / seconds / 1e6 : 0.0; } // MB/s
+
+private:
+    std::size_t bytes = 0;
+    double seconds = 0.0;
+};
@@ -0,0 +1,145 @@
+#include "bookshelf_writer.hpp"
+#include "buffered_writer.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+// Shares the source's extents with a new target on copy-on-write file
+// systems (btrfs, XFS); false where that is not supported
+bool reflink(const std::string &source, const std::string &target)
+{
+#ifdef FICLONE
+    int in = open(source.c_str(), O_RDONLY);
+    if (in < 0)
+    {
+        return false;
+    }
+    int out = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool cloned = out >= 0 && ioctl(out, FICLONE, in) == 0;
+    if (out >= 0 && close(out) != 0)
+    {
+        cloned = false;
+    }
+    close(in);
+    if (!cloned && out >= 0)
+    {
+        unlink(target.c_str());
+    }
+    return cloned;
+#else
+    (void)source;
+    (void)target;
+    return false;
+#endif
+}
+} // namespace
+
+BookshelfWriter::BookshelfWriter(const BookshelfDesign &design, const std::string &dir, const std::string &name)
+    : design(design), dir(dir), name(name)
+{
+}
+
+void BookshelfWriter::writeNodes() const
+{
+    BufferedWriter out(path(".nodes"));
+    long terminal_count = std::count_if(design.nodes.begin(), design.nodes.end(),
+                                        [](const BookshelfNode &node)
+                                        { return node.is_terminal; });
+    for (const auto &header : design.nodes_header)
+    {
+        if (header.find("NumNodes") != std::string::npos)
+        {
+            out << "NumNodes : " << design.nodes.size() << '\n';
+        }
+        else if (header.find("NumTerminals") != std::string::npos)
+        {
+            out << "NumTerminals : " << terminal_count << '\n';
+        }
+        else
+        {
+            out << header << '\n';
+        }
+    }
+
+    for (const BookshelfNode &node : design.nodes)
+    {
+        out << node.name << ' ' << Fixed{node.width, 1} << ' ' << Fixed{node.height, 1};
+        if (node.is_terminal)
+        {
+            out << " terminal";
+        }
+        out << '\n';
+    }
+    out.close();
+}
+
+void BookshelfWriter::writePl(const std::vector<double> &x, const std::vector<double> &y) const
+{
+    BufferedWriter out(path(".pl"));
+    for (const auto &header : design.pl_header)
+    {
+        out << header << '\n';
+    }
+    out << '\n';
+
+    for (std::size_t i = 0; i < design.nodes.size(); ++i)
+    {
+        const BookshelfPlacement &placement = design.placements[i];
+        out << LeftAligned{design.nodes[i].name, 10} << Fixed{x[i], 1, 8} << "  " << Fixed{y[i], 1, 8}
+            << " : " << placement.orientation;
+        if (placement.is_fixed)
+        {
+            out << " /FIXED";
+        }
+        out << '\n';
+    }
+    out.close();
+}
+
+void BookshelfWriter::writeAux() const
+{
+    BufferedWriter out(path(".aux"), 1 << 12);
+    for (const auto &line : design.aux_lines)
+    {
+        if (line.find("RowBasedPlacement") != std::string::npos)
+        {
+            // Replace input filenames with output filenames
+            out << "RowBasedPlacement : " << name << ".nodes " << name << ".nets " << name << ".wts "
+                << name << ".pl " << name << ".scl\n";
+        }
+        else
+        {
+            out << line << '\n';
+        }
+    }
+    out.close();
+}
+
+void BookshelfWriter::linkUnchanged(const std::string &source, const std::string &extension) const
+{
+    const std::string target = path(extension);
+    std::error_code error;
+    if (fs::equivalent(source, target, error))
+    {
+        return;
+    }
+    fs::remove(target);
+    if (reflink(source, target))
+    {
+        return;
+    }
+    fs::create_hard_link(source, target, error);
+    if (error)
+    {
+        fs::copy_file(source, target, fs::copy_options::overwrite_existing);
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "bookshelf.hpp"
+#include <string>
+#include <vector>
+
+// Writers for the output files of a design, <dir>/<name>.nodes, .pl and
+// .aux. Each file goes through its own BufferedWriter, so they can be
+// written on separate threads, and is formatted from the parsed design
+// alone: the inputs are never read again.
+class BookshelfWriter
+{
+public:
+    BookshelfWriter(const BookshelfDesign &design, const std::string &dir, const std::string &name);
+
+    void writeNodes() const;
+    // Placement at the given lower-left corners, indexed like the nodes
+    void writePl(const std::vector<double> &x, const std::vector<double> &y) const;
+    // The input .aux naming this design's files
+    void writeAux() const;
+
+    // Gives <dir>/<name><extension> the contents of `source` without copying
+    // where the file system allows: a reflink, else a hard link, else a copy
+    void linkUnchanged(const std::string &source, const std::string &extension) const;
+
+private:
+    const BookshelfDesign &design;
+    std::string dir;
+    std::string name;
+
+    std::string path(const std::string &extension) const { return dir + "/" + name + extension; }
+};
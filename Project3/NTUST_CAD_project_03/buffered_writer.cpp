@@ -0,0 +1,138 @@
+#include "buffered_writer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace
+{
+void writeAll(int fd, const char *data, std::size_t size, const std::string &filename)
+{
+    while (size > 0)
+    {
+        ssize_t wrote = write(fd, data, size);
+        if (wrote < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::runtime_error("Cannot write file: " + filename);
+        }
+        data += wrote;
+        size -= wrote;
+    }
+}
+} // namespace
+
+BufferedWriter::BufferedWriter(const std::string &filename, std::size_t capacity)
+    : filename(filename), buffer(std::max<std::size_t>(capacity, 64))
+{
+    fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot create output file: " + filename);
+    }
+}
+
+BufferedWriter::~BufferedWriter()
+{
+    if (fd < 0)
+    {
+        return;
+    }
+    try
+    {
+        flush();
+    }
+    catch (const std::exception &)
+    {
+    }
+    ::close(fd);
+}
+
+BufferedWriter &BufferedWriter::operator<<(std::string_view text)
+{
+    if (text.size() > buffer.size() - used)
+    {
+        flush();
+        // Too big to stage: hand it to the file as is
+        if (text.size() > buffer.size())
+        {
+            writeAll(fd, text.data(), text.size(), filename);
+            return *this;
+        }
+    }
+    std::memcpy(buffer.data() + used, text.data(), text.size());
+    used += text.size();
+    return *this;
+}
+
+BufferedWriter &BufferedWriter::operator<<(char c)
+{
+    reserve(1);
+    buffer[used++] = c;
+    return *this;
+}
+
+BufferedWriter &BufferedWriter::operator<<(Fixed number)
+{
+    // Room for any double in fixed notation
+    char digits[512];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number.value, std::chars_format::fixed,
+                                std::min(number.precision, 100));
+    std::size_t length = result.ptr - digits;
+    if (number.width > 0)
+    {
+        pad(static_cast<std::size_t>(number.width) - std::min<std::size_t>(length, number.width));
+    }
+    return *this << std::string_view(digits, length);
+}
+
+BufferedWriter &BufferedWriter::operator<<(LeftAligned text)
+{
+    *this << text.text;
+    pad(text.width - std::min(text.text.size(), text.width));
+    return *this;
+}
+
+void BufferedWriter::pad(std::size_t count)
+{
+    for (; count > 0; --count)
+    {
+        *this << ' ';
+    }
+}
+
+void BufferedWriter::flush()
+{
+    std::size_t size = used;
+    used = 0;
+    writeAll(fd, buffer.data(), size, filename);
+}
+
+void BufferedWriter::close()
+{
+    if (fd < 0)
+    {
+        return;
+    }
+    try
+    {
+        flush();
+    }
+    catch (const std::exception &)
+    {
+        ::close(fd);
+        fd = -1;
+        throw;
+    }
+    int status = ::close(fd);
+    fd = -1;
+    if (status != 0)
+    {
+        throw std::runtime_error("Cannot write file: " + filename);
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// A double printed with a fixed number of decimals, right-aligned in
+// `width` columns like std::setw
+struct Fixed
+{
+    double value;
+    int precision;
+    int width = 0;
+};
+
+// Text left-aligned in `width` columns
+struct LeftAligned
+{
+    std::string_view text;
+    std::size_t width;
+};
+
+// Output file written through one large buffer. Numbers are formatted with
+// std::to_chars straight into the buffer, which reaches the file in large
+// write() calls only when it fills up and on close().
+class BufferedWriter
+{
+public:
+    explicit BufferedWriter(const std::string &filename, std::size_t capacity = 1 << 20);
+    ~BufferedWriter();
+    BufferedWriter(const BufferedWriter &) = delete;
+    BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+    BufferedWriter &operator<<(std::string_view text);
+    BufferedWriter &operator<<(char c);
+    BufferedWriter &operator<<(Fixed number);
+    BufferedWriter &operator<<(LeftAligned text);
+
+    template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+    BufferedWriter &operator<<(T value)
+    {
+        reserve(24);
+        used = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value).ptr - buffer.data();
+        return *this;
+    }
+
+    // Flushes and closes the file; errors are thrown here, the destructor
+    // only cleans up
+    void close();
+
+private:
+    std::string filename;
+    int fd = -1;
+    std::vector<char> buffer;
+    std::size_t used = 0;
+
+    void reserve(std::size_t bytes)
+    {
+        if (buffer.size() - used < bytes)
+        {
+            flush();
+        }
+    }
+    void pad(std::size_t count);
+    void flush();
+};
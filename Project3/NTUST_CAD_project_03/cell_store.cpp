@@ -0,0 +1,38 @@
+#include "cell_store.hpp"
+
+void CellStore::load(const BookshelfDesign &design)
+{
+    const std::size_t n = design.nodes.size();
+    x.resize(n);
+    y.resize(n);
+    width.resize(n);
+    height.resize(n);
+    flags.assign(n, 0);
+    movable.clear();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        x[i] = design.placements[i].x;
+        y[i] = design.placements[i].y;
+        width[i] = design.nodes[i].width;
+        height[i] = design.nodes[i].height;
+        flags[i] = (design.nodes[i].is_terminal ? kTerminal : 0) |
+                   (design.placements[i].is_fixed ? kFixed : 0);
+        if (!flags[i])
+        {
+            movable.push_back(static_cast<int>(i));
+        }
+    }
+    new_x = x;
+    new_y = y;
+}
+
+std::vector<double> CellStore::gatherMovable(const std::vector<double> &column) const
+{
+    std::vector<double> values;
+    values.reserve(movable.size());
+    for (int cell : movable)
+    {
+        values.push_back(column[cell]);
+    }
+    return values;
+}
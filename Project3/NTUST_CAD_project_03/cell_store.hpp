@@ -0,0 +1,31 @@
+#pragma once
+#include "bookshelf.hpp"
+#include <cstdint>
+#include <vector>
+
+// Cells of the design as parallel arrays, indexed like BookshelfDesign::nodes.
+// The legalizer's loops read only these columns; names and orientations stay
+// in the design and are looked up when files are written.
+struct CellStore
+{
+    enum Flag : std::uint8_t
+    {
+        kTerminal = 1,
+        kFixed = 2
+    };
+
+    std::vector<double> x, y;         // Input lower-left corner
+    std::vector<double> new_x, new_y; // Legalized lower-left corner
+    std::vector<double> width, height;
+    std::vector<std::uint8_t> flags;
+    std::vector<int> movable; // Cells neither terminal nor fixed, in index order
+
+    void load(const BookshelfDesign &design);
+
+    std::size_t size() const { return x.size(); }
+    bool isTerminal(std::size_t i) const { return flags[i] & kTerminal; }
+    bool isFixed(std::size_t i) const { return flags[i] & kFixed; }
+
+    // `column` for the movable cells, in the order of `movable`
+    std::vector<double> gatherMovable(const std::vector<double> &column) const;
+};
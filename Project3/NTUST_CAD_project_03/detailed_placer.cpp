@@ -0,0 +1,468 @@
+#include "detailed_placer.hpp"
+#include "parallel.hpp"
+#include "site_rows.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+constexpr double kEpsilon = 1e-6;
+}
+
+DetailedPlacer::DetailedPlacer(const BookshelfDesign &design, CellStore &cells, double displacement_weight,
+                               int threads, int window_rows, int window_sites)
+    : cells(cells), hpwl(design.nets, cells, threads), displacement_weight(displacement_weight),
+      threads(std::max(1, threads)), window_rows(std::max(1, window_rows)), window_sites(std::max(1, window_sites))
+{
+    buildSegments(design);
+}
+
+void DetailedPlacer::buildSegments(const BookshelfDesign &design)
+{
+    for (const SiteRow &row : buildSiteRows(design))
+    {
+        for (const auto &span : row.free.getSpans())
+        {
+            segments.push_back({row.y, row.siteX(span.first), row.siteX(span.second), row.spacing, 0, {}});
+        }
+    }
+    std::stable_sort(segments.begin(), segments.end(), [](const Segment &a, const Segment &b)
+                     { return a.y < b.y || (a.y == b.y && a.min_x < b.min_x); });
+    if (segments.empty())
+    {
+        return;
+    }
+
+    die_min_x = std::numeric_limits<double>::max();
+    die_max_x = std::numeric_limits<double>::lowest();
+    for (std::size_t s = 0; s < segments.size(); ++s)
+    {
+        if (s > 0 && segments[s].y != segments[s - 1].y)
+        {
+            ++levels;
+        }
+        segments[s].level = levels;
+        die_min_x = std::min(die_min_x, segments[s].min_x);
+        die_max_x = std::max(die_max_x, segments[s].max_x);
+    }
+    ++levels;
+    tile_width = window_sites * segments.front().site;
+
+    // Cells the legalizer left off the rows belong to no segment and never move
+    segment_of.assign(cells.size(), -1);
+    for (int cell : cells.movable)
+    {
+        double x = cells.new_x[cell], y = cells.new_y[cell];
+        auto it = std::upper_bound(segments.begin(), segments.end(), std::make_pair(y, x),
+                                   [](const std::pair<double, double> &point, const Segment &segment)
+                                   {
+                                       return point.first < segment.y ||
+                                              (point.first == segment.y && point.second < segment.min_x);
+                                   });
+        if (it == segments.begin())
+        {
+            continue;
+        }
+        --it;
+        if (std::abs(it->y - y) < kEpsilon && x >= it->min_x - kEpsilon &&
+            x + cells.width[cell] <= it->max_x + kEpsilon)
+        {
+            segment_of[cell] = static_cast<int>(it - segments.begin());
+        }
+    }
+}
+
+void DetailedPlacer::run(int passes)
+{
+    auto started = std::chrono::steady_clock::now();
+    swaps = reorders = shifts = 0;
+    for (int pass = 0; pass < passes && !segments.empty(); ++pass)
+    {
+        int moves = swaps + reorders + shifts;
+        runPass(pass);
+        if (swaps + reorders + shifts == moves)
+        {
+            break;
+        }
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+}
+
+void DetailedPlacer::runPass(int pass)
+{
+    const int n = static_cast<int>(cells.size());
+    snap_x = cells.new_x;
+    snap_y = cells.new_y;
+    owner.assign(n, -1);
+    lane_of.assign(n, -1);
+
+    for (Segment &segment : segments)
+    {
+        segment.cells.clear();
+    }
+    for (int cell = 0; cell < n; ++cell)
+    {
+        if (segment_of[cell] != -1)
+        {
+            segments[segment_of[cell]].cells.push_back(cell);
+        }
+    }
+
+    // Odd passes shift the window grid by half a window both ways
+    const int row_offset = pass % 2 ? window_rows / 2 : 0;
+    const double x_offset = pass % 2 ? tile_width / 2 : 0.0;
+    const int bands = (levels - 1 + row_offset) / window_rows + 1;
+    const int tiles = static_cast<int>((die_max_x - die_min_x + x_offset) / tile_width) + 1;
+    auto tileOf = [&](double x)
+    {
+        int tile = static_cast<int>(std::floor((x - die_min_x + x_offset) / tile_width));
+        return std::max(0, std::min(tile, tiles - 1));
+    };
+    auto tileLeft = [&](int tile)
+    {
+        return die_min_x - x_offset + tile * tile_width;
+    };
+
+    std::vector<std::vector<Lane>> window_lanes(static_cast<std::size_t>(bands) * tiles);
+    for (int s = 0; s < static_cast<int>(segments.size()); ++s)
+    {
+        Segment &segment = segments[s];
+        std::sort(segment.cells.begin(), segment.cells.end(), [this](int a, int b)
+                  { return cells.new_x[a] < cells.new_x[b]; });
+
+        const int band = (segment.level + row_offset) / window_rows;
+        const int first_tile = tileOf(segment.min_x);
+        const int last_tile = tileOf(segment.max_x - kEpsilon);
+        std::vector<int> lane_index(last_tile - first_tile + 1);
+        for (int t = first_tile; t <= last_tile; ++t)
+        {
+            std::vector<Lane> &lanes = window_lanes[band * tiles + t];
+            lane_index[t - first_tile] = static_cast<int>(lanes.size());
+            lanes.push_back({s, std::max(segment.min_x, tileLeft(t)), std::min(segment.max_x, tileLeft(t + 1)), {}});
+        }
+        auto laneAt = [&](int t) -> Lane &
+        {
+            return window_lanes[band * tiles + t][lane_index[t - first_tile]];
+        };
+
+        for (int cell : segment.cells)
+        {
+            double x = cells.new_x[cell];
+            int t0 = std::max(first_tile, tileOf(x));
+            int t1 = std::min(last_tile, tileOf(x + cells.width[cell] - kEpsilon));
+            if (t0 == t1)
+            {
+                laneAt(t0).cells.push_back(cell);
+                owner[cell] = band * tiles + t0;
+                lane_of[cell] = lane_index[t0 - first_tile];
+                continue;
+            }
+            // A cell across a window edge is a wall for the lanes it touches
+            laneAt(t0).right = std::min(laneAt(t0).right, x);
+            laneAt(t1).left = std::max(laneAt(t1).left, x + cells.width[cell]);
+            for (int t = t0 + 1; t < t1; ++t)
+            {
+                laneAt(t).left = laneAt(t).right;
+            }
+        }
+    }
+
+    std::vector<Counts> counts(window_lanes.size());
+    runParallel(static_cast<int>(window_lanes.size()), threads, [&](int w)
+                { optimizeWindow(w, window_lanes[w], counts[w]); });
+    for (const Counts &window : counts)
+    {
+        swaps += window.swaps;
+        reorders += window.reorders;
+        shifts += window.shifts;
+    }
+}
+
+void DetailedPlacer::optimizeWindow(int window, std::vector<Lane> &lanes, Counts &counts)
+{
+    std::vector<int> order;
+    for (const Lane &lane : lanes)
+    {
+        order.insert(order.end(), lane.cells.begin(), lane.cells.end());
+    }
+    for (int cell : order)
+    {
+        counts.swaps += globalSwap(window, lanes, cell);
+    }
+    for (Lane &lane : lanes)
+    {
+        for (int i = 0; i + 2 < static_cast<int>(lane.cells.size()); ++i)
+        {
+            counts.reorders += reorder(window, lane, i);
+        }
+    }
+    for (Lane &lane : lanes)
+    {
+        for (int i = 0; i < static_cast<int>(lane.cells.size()); ++i)
+        {
+            counts.shifts += shift(window, lane, i);
+        }
+    }
+}
+
+bool DetailedPlacer::globalSwap(int window, std::vector<Lane> &lanes, int cell)
+{
+    auto view = [&](int other)
+    {
+        return position(window, other);
+    };
+    double target_x, target_y;
+    if (!hpwl.optimalRegion(cell, view, target_x, target_y))
+    {
+        return false;
+    }
+
+    // The window lane closest to the optimal region
+    int target = -1;
+    double nearest = std::numeric_limits<double>::max();
+    for (int l = 0; l < static_cast<int>(lanes.size()); ++l)
+    {
+        const Lane &lane = lanes[l];
+        if (lane.right - lane.left < cells.width[cell] - kEpsilon)
+        {
+            continue;
+        }
+        double distance = std::abs(segments[lane.segment].y - target_y) +
+                          std::max({0.0, lane.left - target_x, target_x - lane.right});
+        if (distance < nearest)
+        {
+            nearest = distance;
+            target = l;
+        }
+    }
+    const int home = lane_of[cell];
+    const double x = cells.new_x[cell], y = cells.new_y[cell];
+    if (target == -1 || (target == home && std::abs(target_x - x) <= cells.width[cell]))
+    {
+        return false;
+    }
+
+    Lane &lane = lanes[target];
+    const Segment &segment = segments[lane.segment];
+    const int size = static_cast<int>(lane.cells.size());
+    const int j = static_cast<int>(
+        std::lower_bound(lane.cells.begin(), lane.cells.end(), target_x,
+                         [this](int other, double value)
+                         { return cells.new_x[other] < value; }) -
+        lane.cells.begin());
+
+    std::vector<CellMove> best;
+    double best_cost = -kEpsilon;
+    auto consider = [&](std::vector<CellMove> moves)
+    {
+        double change = cost(window, moves);
+        if (change < best_cost)
+        {
+            best_cost = change;
+            best = std::move(moves);
+        }
+    };
+
+    // The gap at the optimal region, not counting the cell itself
+    int prev = j - 1, next = j;
+    if (prev >= 0 && lane.cells[prev] == cell)
+    {
+        --prev;
+    }
+    if (next < size && lane.cells[next] == cell)
+    {
+        ++next;
+    }
+    double lo = prev >= 0 ? cells.new_x[lane.cells[prev]] + cells.width[lane.cells[prev]] : lane.left;
+    double hi = next < size ? cells.new_x[lane.cells[next]] : lane.right;
+    double gap_x;
+    if (fitX(segment, target_x, lo, hi, cells.width[cell], gap_x) &&
+        (target != home || std::abs(gap_x - x) > kEpsilon))
+    {
+        consider({{cell, gap_x, segment.y}});
+    }
+
+    // Cells of the same width around the optimal region
+    for (int k = std::max(0, j - 2); k < std::min(size, j + 2); ++k)
+    {
+        int other = lane.cells[k];
+        if (other != cell && std::abs(cells.width[other] - cells.width[cell]) < kEpsilon)
+        {
+            consider({{cell, cells.new_x[other], cells.new_y[other]}, {other, x, y}});
+        }
+    }
+    if (best.empty())
+    {
+        return false;
+    }
+
+    Lane &from = lanes[home];
+    if (best.size() == 1)
+    {
+        from.cells.erase(from.cells.begin() + indexIn(from, cell));
+        cells.new_x[cell] = best[0].x;
+        cells.new_y[cell] = best[0].y;
+        lane.cells.insert(std::lower_bound(lane.cells.begin(), lane.cells.end(), best[0].x,
+                                           [this](int other, double value)
+                                           { return cells.new_x[other] < value; }),
+                          cell);
+        lane_of[cell] = target;
+        segment_of[cell] = lane.segment;
+        return true;
+    }
+
+    // Same widths, so each cell takes the other's slot in its lane's order
+    int other = best[1].cell;
+    int from_index = indexIn(from, cell), to_index = indexIn(lane, other);
+    for (const CellMove &move : best)
+    {
+        cells.new_x[move.cell] = move.x;
+        cells.new_y[move.cell] = move.y;
+    }
+    from.cells[from_index] = other;
+    lane.cells[to_index] = cell;
+    std::swap(lane_of[cell], lane_of[other]);
+    std::swap(segment_of[cell], segment_of[other]);
+    return true;
+}
+
+bool DetailedPlacer::reorder(int window, Lane &lane, int first)
+{
+    const Segment &segment = segments[lane.segment];
+    const int size = static_cast<int>(lane.cells.size());
+    const double left = cells.new_x[lane.cells[first]];
+    const double limit = first + 3 < size ? cells.new_x[lane.cells[first + 3]] : lane.right;
+
+    int order[3] = {0, 1, 2};
+    std::vector<CellMove> best;
+    double best_cost = -kEpsilon;
+    while (std::next_permutation(order, order + 3))
+    {
+        std::vector<CellMove> moves;
+        double x = left;
+        for (int k : order)
+        {
+            int cell = lane.cells[first + k];
+            moves.push_back({cell, x, segment.y});
+            double end = x + cells.width[cell] - segment.min_x;
+            x = segment.min_x + std::ceil(end / segment.site - kEpsilon) * segment.site;
+        }
+        const CellMove &last = moves.back();
+        if (last.x + cells.width[last.cell] > limit + kEpsilon)
+        {
+            continue;
+        }
+        double change = cost(window, moves);
+        if (change < best_cost)
+        {
+            best_cost = change;
+            best = std::move(moves);
+        }
+    }
+    if (best.empty())
+    {
+        return false;
+    }
+
+    for (int k = 0; k < 3; ++k)
+    {
+        cells.new_x[best[k].cell] = best[k].x;
+        lane.cells[first + k] = best[k].cell;
+    }
+    return true;
+}
+
+bool DetailedPlacer::shift(int window, Lane &lane, int index)
+{
+    const Segment &segment = segments[lane.segment];
+    const int size = static_cast<int>(lane.cells.size());
+    const int cell = lane.cells[index];
+    const double x = cells.new_x[cell];
+    const double lo = index > 0 ? cells.new_x[lane.cells[index - 1]] + cells.width[lane.cells[index - 1]]
+                                : lane.left;
+    const double hi = index + 1 < size ? cells.new_x[lane.cells[index + 1]] : lane.right;
+
+    std::vector<double> targets{cells.x[cell]};
+    double target_x, target_y;
+    if (hpwl.optimalRegion(cell, [&](int other)
+                           { return position(window, other); },
+                           target_x, target_y))
+    {
+        targets.push_back(target_x);
+    }
+
+    double best_x = x;
+    double best_cost = -kEpsilon;
+    for (double target : targets)
+    {
+        double new_x;
+        if (!fitX(segment, target, lo, hi, cells.width[cell], new_x) || std::abs(new_x - x) < kEpsilon)
+        {
+            continue;
+        }
+        double change = cost(window, {{cell, new_x, segment.y}});
+        if (change < best_cost)
+        {
+            best_cost = change;
+            best_x = new_x;
+        }
+    }
+    if (best_x == x)
+    {
+        return false;
+    }
+    cells.new_x[cell] = best_x;
+    return true;
+}
+
+// A window's own cells where it has moved them, all others as of the pass start
+std::pair<double, double> DetailedPlacer::position(int window, int cell) const
+{
+    if (owner[cell] == window)
+    {
+        return {cells.new_x[cell], cells.new_y[cell]};
+    }
+    return {snap_x[cell], snap_y[cell]};
+}
+
+double DetailedPlacer::cost(int window, const std::vector<CellMove> &moves) const
+{
+    double change = hpwl.deltaAt(moves, [&](int cell)
+                                 { return position(window, cell); });
+    for (const CellMove &move : moves)
+    {
+        std::pair<double, double> at = position(window, move.cell);
+        double before = std::abs(at.first - cells.x[move.cell]) + std::abs(at.second - cells.y[move.cell]);
+        double after = std::abs(move.x - cells.x[move.cell]) + std::abs(move.y - cells.y[move.cell]);
+        change += displacement_weight * (after - before);
+    }
+    return change;
+}
+
+int DetailedPlacer::indexIn(const Lane &lane, int cell) const
+{
+    auto it = std::lower_bound(lane.cells.begin(), lane.cells.end(), cells.new_x[cell],
+                               [this](int other, double value)
+                               { return cells.new_x[other] < value; });
+    while (*it != cell)
+    {
+        ++it;
+    }
+    return static_cast<int>(it - lane.cells.begin());
+}
+
+bool DetailedPlacer::fitX(const Segment &segment, double target, double lo, double hi, double width,
+                          double &x) const
+{
+    int lo_site = static_cast<int>(std::ceil((lo - segment.min_x) / segment.site - kEpsilon));
+    int hi_site = static_cast<int>(std::floor((hi - width - segment.min_x) / segment.site + kEpsilon));
+    if (lo_site > hi_site)
+    {
+        return false;
+    }
+    int site = static_cast<int>(std::lround((target - segment.min_x) / segment.site));
+    x = segment.min_x + std::max(lo_site, std::min(site, hi_site)) * segment.site;
+    return true;
+}
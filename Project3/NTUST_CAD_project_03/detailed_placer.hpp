@@ -0,0 +1,104 @@
+#pragma once
+#include "bookshelf.hpp"
+#include "cell_store.hpp"
+#include "hpwl.hpp"
+#include <utility>
+#include <vector>
+
+// Wirelength-driven detailed placement of a legal placement. Every move keeps
+// the cells on the site grid of their free spans and is taken only when
+//     HPWL change + displacement_weight * displacement change
+// is negative, displacement being the Manhattan distance to the input corner.
+// The moves, tried in this order for every cell of a window:
+//   - global swap: the cell goes to the gap nearest its optimal region, or
+//     trades places with a cell of the same width there
+//   - local reordering: the best order of three neighbouring cells, packed
+//     from the left edge of the first
+//   - shifting: the cell slides between its neighbours towards its optimal
+//     region or its input position
+//
+// The die is cut into windows of `window_rows` rows by `window_sites` sites,
+// offset by half a window on every other pass. A window owns the cells lying
+// wholly inside it; cells across a window edge stay put that pass and bound
+// their lanes. Windows run in parallel and see each other's cells as they
+// were when the pass began, so the result is the same for any thread count.
+class DetailedPlacer
+{
+public:
+    DetailedPlacer(const BookshelfDesign &design, CellStore &cells, double displacement_weight, int threads,
+                   int window_rows = 8, int window_sites = 256);
+
+    // Improves the legalized positions in the store over `passes` passes
+    void run(int passes);
+
+    int getSwaps() const { return swaps; }
+    int getReorders() const { return reorders; }
+    int getShifts() const { return shifts; }
+    double getSeconds() const { return seconds; }
+
+private:
+    // A free span of a subrow and the movable cells in it, left to right
+    struct Segment
+    {
+        double y;
+        double min_x;
+        double max_x;
+        double site;
+        int level; // Index of the segment's y among all row y values
+        std::vector<int> cells;
+    };
+
+    // The part of a segment one window owns, between two walls
+    struct Lane
+    {
+        int segment;
+        double left;
+        double right;
+        std::vector<int> cells;
+    };
+
+    struct Counts
+    {
+        int swaps = 0;
+        int reorders = 0;
+        int shifts = 0;
+    };
+
+    CellStore &cells;
+    HpwlEvaluator hpwl;
+    double displacement_weight;
+    int threads;
+    int window_rows;
+    int window_sites;
+    std::vector<Segment> segments;
+    int levels = 0;
+    double die_min_x = 0.0;
+    double die_max_x = 0.0;
+    double tile_width = 1.0;
+    int swaps = 0;
+    int reorders = 0;
+    int shifts = 0;
+    double seconds = 0.0;
+
+    // Per pass: the positions other windows are seen at, the window owning
+    // each cell (-1 for none) and the lane it is in
+    std::vector<double> snap_x, snap_y;
+    std::vector<int> owner, lane_of;
+    std::vector<int> segment_of; // Segment of each cell, -1 for cells off the rows
+
+    void buildSegments(const BookshelfDesign &design);
+    void runPass(int pass);
+    void optimizeWindow(int window, std::vector<Lane> &lanes, Counts &counts);
+
+    bool globalSwap(int window, std::vector<Lane> &lanes, int cell);
+    bool reorder(int window, Lane &lane, int first);
+    bool shift(int window, Lane &lane, int index);
+
+    std::pair<double, double> position(int window, int cell) const;
+    double cost(int window, const std::vector<CellMove> &moves) const;
+    int indexIn(const Lane &lane, int cell) const;
+
+    // Site-grid x nearest `target` that keeps a cell of `width` in [lo, hi],
+    // or false when it does not fit
+    bool fitX(const Segment &segment, double target, double lo, double hi, double width, double &x) const;
+};
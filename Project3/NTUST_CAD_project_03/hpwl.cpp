@@ -0,0 +1,109 @@
+#include "hpwl.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+
+constexpr int kNetBlock = 1024;
+
+} // namespace
+
+HpwlEvaluator::HpwlEvaluator(const BookshelfNets &nets, const CellStore &cells, int threads)
+    : nets(nets), cells(cells), threads(std::max(1, threads))
+{
+    const int num_pins = static_cast<int>(nets.pin_node.size());
+    pin_net.resize(num_pins);
+    for (int net = 0; net < nets.size(); ++net)
+    {
+        std::fill(pin_net.begin() + nets.net_start[net], pin_net.begin() + nets.net_start[net + 1], net);
+    }
+
+    cell_start.assign(cells.size() + 1, 0);
+    for (int pin = 0; pin < num_pins; ++pin)
+    {
+        ++cell_start[nets.pin_node[pin] + 1];
+    }
+    for (std::size_t c = 0; c < cells.size(); ++c)
+    {
+        cell_start[c + 1] += cell_start[c];
+    }
+    cell_pins.resize(num_pins);
+    std::vector<int> fill(cell_start.begin(), cell_start.end() - 1);
+    for (int pin = 0; pin < num_pins; ++pin)
+    {
+        cell_pins[fill[nets.pin_node[pin]]++] = pin;
+    }
+    net_hpwl.assign(nets.size(), 0.0);
+}
+
+double HpwlEvaluator::netHpwl(int net, const std::vector<CellMove> &moves) const
+{
+    const std::vector<double> &xs = legalized ? cells.new_x : cells.x;
+    const std::vector<double> &ys = legalized ? cells.new_y : cells.y;
+    return netHpwlAt(net, moves, [&](int cell)
+                     { return std::make_pair(xs[cell], ys[cell]); });
+}
+
+std::vector<int> HpwlEvaluator::touchedNets(const std::vector<CellMove> &moves) const
+{
+    std::vector<int> touched;
+    for (const CellMove &move : moves)
+    {
+        for (int k = cell_start[move.cell]; k < cell_start[move.cell + 1]; ++k)
+        {
+            touched.push_back(pin_net[cell_pins[k]]);
+        }
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    return touched;
+}
+
+double HpwlEvaluator::evaluate(bool legalized)
+{
+    auto started = std::chrono::steady_clock::now();
+    this->legalized = legalized;
+    const int num_nets = nets.size();
+    const int blocks = (num_nets + kNetBlock - 1) / kNetBlock;
+    std::vector<double> block_sum(blocks, 0.0);
+    const std::vector<CellMove> none;
+    runParallel(blocks, threads, [&](int b)
+                {
+                    int end = std::min(num_nets, (b + 1) * kNetBlock);
+                    for (int net = b * kNetBlock; net < end; ++net)
+                    {
+                        net_hpwl[net] = netHpwl(net, none);
+                        block_sum[b] += net_hpwl[net];
+                    }
+                });
+
+    total = 0.0;
+    for (double sum : block_sum)
+    {
+        total += sum;
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return total;
+}
+
+double HpwlEvaluator::delta(const std::vector<CellMove> &moves) const
+{
+    double change = 0.0;
+    for (int net : touchedNets(moves))
+    {
+        change += netHpwl(net, moves) - net_hpwl[net];
+    }
+    return change;
+}
+
+void HpwlEvaluator::commit(const std::vector<CellMove> &moves)
+{
+    for (int net : touchedNets(moves))
+    {
+        double value = netHpwl(net, moves);
+        total += value - net_hpwl[net];
+        net_hpwl[net] = value;
+    }
+}
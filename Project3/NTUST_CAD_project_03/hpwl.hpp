@@ -0,0 +1,157 @@
+#pragma once
+#include "bookshelf.hpp"
+#include "cell_store.hpp"
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// A candidate lower-left corner for one cell
+struct CellMove
+{
+    int cell;
+    double x;
+    double y;
+};
+
+// Half-perimeter wirelength of the design's nets, with each pin at its
+// node's centre plus the pin offset. Besides the net -> pins lists of
+// BookshelfNets it builds cell -> pins lists and caches the HPWL of every
+// net, so the change a move makes is found from the nets of the moved cells
+// alone, in time linear in their degrees.
+class HpwlEvaluator
+{
+public:
+    HpwlEvaluator(const BookshelfNets &nets, const CellStore &cells, int threads);
+
+    // Sums all nets at the cells' legalized (or input) positions on
+    // `threads` threads and caches the per-net values. Nets are summed in
+    // fixed blocks, so the result does not depend on the thread count.
+    double evaluate(bool legalized = true);
+
+    // Change in HPWL if `moves` were applied to the cached positions
+    double delta(const std::vector<CellMove> &moves) const;
+
+    // Updates the cache for `moves`; the caller moves the cells in the store
+    void commit(const std::vector<CellMove> &moves);
+
+    // Change in HPWL of `moves` with the other cells where `position(cell)`
+    // puts them (an x, y pair). Measures the touched nets afresh and leaves
+    // the cache alone, so concurrent callers can use their own views.
+    template <typename Position>
+    double deltaAt(const std::vector<CellMove> &moves, Position position) const
+    {
+        const std::vector<CellMove> none;
+        double change = 0.0;
+        for (int net : touchedNets(moves))
+        {
+            change += netHpwlAt(net, moves, position) - netHpwlAt(net, none, position);
+        }
+        return change;
+    }
+
+    // Lower-left corner that puts the cell's centre at the median of its
+    // nets' bounding boxes without it, where its HPWL is lowest. False for
+    // a cell on no net with other pins.
+    template <typename Position>
+    bool optimalRegion(int cell, Position position, double &x, double &y) const;
+
+    double getTotal() const { return total; }
+    double getSeconds() const { return seconds; }
+
+private:
+    const BookshelfNets &nets;
+    const CellStore &cells;
+    int threads;
+    bool legalized = true;
+    std::vector<int> pin_net;    // Net of each pin
+    std::vector<int> cell_start; // Pins of cell c are cell_pins[cell_start[c] .. cell_start[c + 1])
+    std::vector<int> cell_pins;
+    std::vector<double> net_hpwl;
+    double total = 0.0;
+    double seconds = 0.0;
+
+    double netHpwl(int net, const std::vector<CellMove> &moves) const;
+    template <typename Position>
+    double netHpwlAt(int net, const std::vector<CellMove> &moves, Position position) const;
+    std::vector<int> touchedNets(const std::vector<CellMove> &moves) const;
+};
+
+// Bounding box of the net's pins, with moved cells taken from `moves`
+template <typename Position>
+double HpwlEvaluator::netHpwlAt(int net, const std::vector<CellMove> &moves, Position position) const
+{
+    if (nets.net_start[net + 1] - nets.net_start[net] < 2)
+    {
+        return 0.0;
+    }
+    double min_x = std::numeric_limits<double>::max(), max_x = std::numeric_limits<double>::lowest();
+    double min_y = min_x, max_y = max_x;
+    for (int pin = nets.net_start[net]; pin < nets.net_start[net + 1]; ++pin)
+    {
+        int cell = nets.pin_node[pin];
+        std::pair<double, double> at = position(cell);
+        for (const CellMove &move : moves)
+        {
+            if (move.cell == cell)
+            {
+                at = {move.x, move.y};
+            }
+        }
+        double x = at.first + cells.width[cell] / 2 + nets.pin_dx[pin];
+        double y = at.second + cells.height[cell] / 2 + nets.pin_dy[pin];
+        min_x = std::min(min_x, x);
+        max_x = std::max(max_x, x);
+        min_y = std::min(min_y, y);
+        max_y = std::max(max_y, y);
+    }
+    return (max_x - min_x) + (max_y - min_y);
+}
+
+template <typename Position>
+bool HpwlEvaluator::optimalRegion(int cell, Position position, double &x, double &y) const
+{
+    std::vector<double> xs, ys;
+    for (int k = cell_start[cell]; k < cell_start[cell + 1]; ++k)
+    {
+        int net = pin_net[cell_pins[k]];
+        double min_x = std::numeric_limits<double>::max(), max_x = std::numeric_limits<double>::lowest();
+        double min_y = min_x, max_y = max_x;
+        for (int pin = nets.net_start[net]; pin < nets.net_start[net + 1]; ++pin)
+        {
+            int other = nets.pin_node[pin];
+            if (other == cell)
+            {
+                continue;
+            }
+            std::pair<double, double> at = position(other);
+            double pin_x = at.first + cells.width[other] / 2 + nets.pin_dx[pin];
+            double pin_y = at.second + cells.height[other] / 2 + nets.pin_dy[pin];
+            min_x = std::min(min_x, pin_x);
+            max_x = std::max(max_x, pin_x);
+            min_y = std::min(min_y, pin_y);
+            max_y = std::max(max_y, pin_y);
+        }
+        if (min_x <= max_x)
+        {
+            xs.push_back(min_x);
+            xs.push_back(max_x);
+            ys.push_back(min_y);
+            ys.push_back(max_y);
+        }
+    }
+    if (xs.empty())
+    {
+        return false;
+    }
+
+    auto median = [](std::vector<double> &values)
+    {
+        auto middle = values.begin() + values.size() / 2;
+        std::nth_element(values.begin(), middle, values.end());
+        return *middle;
+    };
+    x = median(xs) - cells.width[cell] / 2;
+    y = median(ys) - cells.height[cell] / 2;
+    return true;
+}
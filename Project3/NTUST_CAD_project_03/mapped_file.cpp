@@ -0,0 +1,54 @@
+#include "mapped_file.hpp"
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string &filename)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open input file: " + filename);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void *view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED)
+        {
+            madvise(view, info.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char *>(view);
+            length = info.st_size;
+            mapped = true;
+        }
+    }
+
+    if (!mapped)
+    {
+        char chunk[1 << 16];
+        ssize_t got;
+        while ((got = read(fd, chunk, sizeof(chunk))) > 0)
+        {
+            buffer.append(chunk, got);
+        }
+        if (got < 0)
+        {
+            close(fd);
+            throw std::runtime_error("Cannot read input file: " + filename);
+        }
+        data = buffer.data();
+        length = buffer.size();
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (mapped)
+    {
+        munmap(const_cast<char *>(data), length);
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file. Regular files are memory-mapped so they
+// can be parsed in place; anything else (pipes, empty files) is read into
+// a private buffer.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &filename);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *begin() const { return data; }
+    const char *end() const { return data + length; }
+    std::size_t size() const { return length; }
+
+private:
+    const char *data = nullptr;
+    std::size_t length = 0;
+    bool mapped = false;
+    std::string buffer;
+};
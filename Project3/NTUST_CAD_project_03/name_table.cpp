@@ -0,0 +1,89 @@
+#include "name_table.hpp"
+
+void NameTable::clear()
+{
+    arena.clear();
+    offsets.assign(1, 0);
+    slots.clear();
+}
+
+void NameTable::reserve(std::size_t names, std::size_t bytes)
+{
+    arena.reserve(bytes);
+    offsets.reserve(names + 1);
+    std::size_t capacity = 16;
+    while (capacity < 2 * names)
+    {
+        capacity *= 2;
+    }
+    if (capacity > slots.size())
+    {
+        rehash(capacity);
+    }
+}
+
+// FNV-1a
+std::uint64_t NameTable::hash(std::string_view name)
+{
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : name)
+    {
+        h = (h ^ c) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// Slot holding `name`, or the empty slot where it would go
+std::size_t NameTable::probe(std::string_view name, std::uint64_t h) const
+{
+    const std::size_t mask = slots.size() - 1;
+    const std::uint32_t tag = static_cast<std::uint32_t>(h);
+    for (std::size_t s = (h >> 32) & mask;; s = (s + 1) & mask)
+    {
+        const Slot &slot = slots[s];
+        if (slot.index == npos || (slot.hash == tag && this->name(slot.index) == name))
+        {
+            return s;
+        }
+    }
+}
+
+void NameTable::rehash(std::size_t capacity)
+{
+    slots.assign(capacity, Slot{0, npos});
+    for (int i = 0; i < size(); ++i)
+    {
+        std::uint64_t h = hash(name(i));
+        slots[probe(name(i), h)] = Slot{static_cast<std::uint32_t>(h), i};
+    }
+}
+
+int NameTable::intern(std::string_view name)
+{
+    if (2 * (size() + 1) > static_cast<int>(slots.size()))
+    {
+        rehash(slots.empty() ? 16 : 2 * slots.size());
+    }
+
+    std::uint64_t h = hash(name);
+    std::size_t s = probe(name, h);
+    if (slots[s].index != npos)
+    {
+        return slots[s].index;
+    }
+
+    int index = size();
+    arena.append(name);
+    offsets.push_back(arena.size());
+    slots[s] = Slot{static_cast<std::uint32_t>(h), index};
+    return index;
+}
+
+int NameTable::find(std::string_view name) const
+{
+    if (slots.empty())
+    {
+        return npos;
+    }
+    return slots[probe(name, hash(name))].index;
+}
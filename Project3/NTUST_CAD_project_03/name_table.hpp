@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Interned node names. Every distinct name is stored once in a character
+// arena and numbered densely in insertion order; a flat open-addressing
+// table (linear probing, power-of-two size, at most half full) maps names
+// to their numbers, so a lookup is one hash and usually one compare.
+class NameTable
+{
+public:
+    static constexpr int npos = -1;
+
+    void clear();
+    void reserve(std::size_t names, std::size_t bytes);
+
+    // Number of `name`, assigning the next one if it is new
+    int intern(std::string_view name);
+
+    // Number of `name`, or npos
+    int find(std::string_view name) const;
+
+    std::string_view name(int index) const
+    {
+        return std::string_view(arena.data() + offsets[index], offsets[index + 1] - offsets[index]);
+    }
+
+    int size() const { return static_cast<int>(offsets.size()) - 1; }
+
+private:
+    struct Slot
+    {
+        std::uint32_t hash; // Low bits of the full hash, checked before the bytes
+        int index;          // npos when empty
+    };
+
+    std::string arena;
+    std::vector<std::size_t> offsets{0}; // Name i spans [offsets[i], offsets[i + 1])
+    std::vector<Slot> slots;
+
+    static std::uint64_t hash(std::string_view name);
+    std::size_t probe(std::string_view name, std::uint64_t h) const;
+    void rehash(std::size_t capacity);
+};
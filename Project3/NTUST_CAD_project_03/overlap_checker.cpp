@@ -0,0 +1,140 @@
+#include "overlap_checker.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <future>
+
+OverlapChecker::OverlapChecker(double bin_height, int threads, bool keep_pairs)
+    : bin_height(bin_height), threads(std::max(1, threads)), keep_pairs(keep_pairs)
+{
+}
+
+double OverlapChecker::check(const std::vector<double> &x, const std::vector<double> &y,
+                             const std::vector<double> &width, const std::vector<double> &height)
+{
+    auto started = std::chrono::steady_clock::now();
+    pairs.clear();
+    const int n = static_cast<int>(x.size());
+
+    double min_y = 0.0, max_y = 0.0;
+    bool any = false;
+    for (int i = 0; i < n; ++i)
+    {
+        if (width[i] > 0 && height[i] > 0)
+        {
+            min_y = any ? std::min(min_y, y[i]) : y[i];
+            max_y = any ? std::max(max_y, y[i] + height[i]) : y[i] + height[i];
+            any = true;
+        }
+    }
+    if (!any)
+    {
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return 0.0;
+    }
+
+    // Cell i lies in bins [first_bin[i], last_bin[i]]; empty cells in none
+    const int num_bins = static_cast<int>((max_y - min_y) / bin_height) + 1;
+    std::vector<int> first_bin(n, 0), last_bin(n, -1);
+    std::vector<int> bin_start(num_bins + 1, 0);
+    for (int i = 0; i < n; ++i)
+    {
+        if (width[i] > 0 && height[i] > 0)
+        {
+            first_bin[i] = static_cast<int>((y[i] - min_y) / bin_height);
+            last_bin[i] = std::min(num_bins - 1,
+                                   static_cast<int>(std::ceil((y[i] + height[i] - min_y) / bin_height)) - 1);
+            last_bin[i] = std::max(last_bin[i], first_bin[i]);
+            for (int b = first_bin[i]; b <= last_bin[i]; ++b)
+            {
+                ++bin_start[b + 1];
+            }
+        }
+    }
+    for (int b = 0; b < num_bins; ++b)
+    {
+        bin_start[b + 1] += bin_start[b];
+    }
+    std::vector<int> bin_cells(bin_start[num_bins]);
+    std::vector<int> fill(bin_start.begin(), bin_start.end() - 1);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int b = first_bin[i]; b <= last_bin[i]; ++b)
+        {
+            bin_cells[fill[b]++] = i;
+        }
+    }
+
+    // Sweeps bins [begin, end) into bin_total and `found`
+    std::vector<double> bin_total(num_bins, 0.0);
+    auto sweep = [&](int begin, int end, std::vector<OverlapPair> &found)
+    {
+        std::vector<int> active;
+        for (int b = begin; b < end; ++b)
+        {
+            auto first = bin_cells.begin() + bin_start[b];
+            auto last = bin_cells.begin() + bin_start[b + 1];
+            std::sort(first, last, [&](int p, int q)
+                      { return x[p] < x[q] || (x[p] == x[q] && p < q); });
+
+            active.clear();
+            double total = 0.0;
+            for (auto it = first; it != last; ++it)
+            {
+                int c = *it;
+                active.erase(std::remove_if(active.begin(), active.end(), [&](int a)
+                                            { return x[a] + width[a] <= x[c]; }),
+                             active.end());
+                for (int a : active)
+                {
+                    // Count the pair only in the bin of its intersection's bottom
+                    int bottom = y[a] >= y[c] ? a : c;
+                    if (first_bin[bottom] != b)
+                    {
+                        continue;
+                    }
+                    double x_overlap = std::min(x[a] + width[a], x[c] + width[c]) - x[c];
+                    double y_overlap = std::min(y[a] + height[a], y[c] + height[c]) - std::max(y[a], y[c]);
+                    if (x_overlap > 0 && y_overlap > 0)
+                    {
+                        total += x_overlap * y_overlap;
+                        if (keep_pairs)
+                        {
+                            found.push_back({std::min(a, c), std::max(a, c), x_overlap * y_overlap});
+                        }
+                    }
+                }
+                active.push_back(c);
+            }
+            bin_total[b] = total;
+        }
+    };
+
+    const int num_tasks = std::min(threads, num_bins);
+    std::vector<std::vector<OverlapPair>> found(num_tasks);
+    std::vector<std::future<void>> tasks;
+    for (int t = 0; t < num_tasks; ++t)
+    {
+        int begin = static_cast<int>(static_cast<long long>(num_bins) * t / num_tasks);
+        int end = static_cast<int>(static_cast<long long>(num_bins) * (t + 1) / num_tasks);
+        tasks.push_back(std::async(num_tasks > 1 ? std::launch::async : std::launch::deferred,
+                                   sweep, begin, end, std::ref(found[t])));
+    }
+    for (auto &task : tasks)
+    {
+        task.get();
+    }
+
+    double total = 0.0;
+    for (double value : bin_total)
+    {
+        total += value;
+    }
+    for (auto &part : found)
+    {
+        pairs.insert(pairs.end(), part.begin(), part.end());
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return total;
+}
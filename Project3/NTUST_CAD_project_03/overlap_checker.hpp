@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+
+// Two cells that overlap, as indices into the checked arrays (a < b)
+struct OverlapPair
+{
+    int a;
+    int b;
+    double area;
+};
+
+// Total pairwise overlap area of a set of rectangles. Cells are bucketed
+// into horizontal bins of `bin_height` (the row height) and each bin is
+// swept in x order, keeping only the cells whose right edge has not been
+// passed, so a legal placement is checked in O(n log n). A pair is counted
+// in the bin holding the bottom of its intersection, which makes the total
+// exact also for cells that span several bins. Bins are split among
+// `threads` tasks and summed in bin order, so the total does not depend on
+// the thread count.
+class OverlapChecker
+{
+public:
+    OverlapChecker(double bin_height, int threads, bool keep_pairs = false);
+
+    double check(const std::vector<double> &x, const std::vector<double> &y,
+                 const std::vector<double> &width, const std::vector<double> &height);
+
+    // Overlapping pairs of the last check, by bin and then by x, when kept
+    const std::vector<OverlapPair> &getPairs() const { return pairs; }
+    double getSeconds() const { return seconds; }
+
+private:
+    double bin_height;
+    int threads;
+    bool keep_pairs;
+    std::vector<OverlapPair> pairs;
+    double seconds = 0.0;
+};
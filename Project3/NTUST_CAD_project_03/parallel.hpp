@@ -0,0 +1,32 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <vector>
+
+// Runs task(0) .. task(count - 1) on up to `threads` threads, the calling
+// thread included. Tasks are handed out in index order; a task must only
+// write state of its own index for results to be independent of `threads`.
+template <typename Task>
+void runParallel(int count, int threads, Task task)
+{
+    std::atomic<int> next{0};
+    auto worker = [&]
+    {
+        for (int i; (i = next++) < count;)
+        {
+            task(i);
+        }
+    };
+
+    std::vector<std::future<void>> workers;
+    for (int t = 1; t < std::min(threads, count); ++t)
+    {
+        workers.push_back(std::async(std::launch::async, worker));
+    }
+    worker();
+    for (auto &future : workers)
+    {
+        future.get();
+    }
+}
@@ -0,0 +1,302 @@
+#include "placement_renderer.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+// Outline and density colour, #800080
+constexpr std::uint8_t kRed = 0x80, kGreen = 0x00, kBlue = 0x80;
+
+// Pixels per side of the squares a dense SVG is drawn with
+constexpr int kSvgBlock = 4;
+
+std::uint32_t crc32(const std::uint8_t *data, std::size_t length, std::uint32_t crc = 0)
+{
+    static const std::array<std::uint32_t, 256> table = []
+    {
+        std::array<std::uint32_t, 256> entries{};
+        for (std::uint32_t n = 0; n < 256; ++n)
+        {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+            {
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[n] = c;
+        }
+        return entries;
+    }();
+    crc = ~crc;
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void putBigEndian(std::vector<std::uint8_t> &out, std::uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        out.push_back(static_cast<std::uint8_t>(value >> shift));
+    }
+}
+
+void writeBigEndian(std::ofstream &out, std::uint32_t value)
+{
+    char bytes[4] = {static_cast<char>(value >> 24), static_cast<char>(value >> 16),
+                     static_cast<char>(value >> 8), static_cast<char>(value)};
+    out.write(bytes, 4);
+}
+
+// Length, type, data and the CRC of type and data
+void writeChunk(std::ofstream &out, const char *type, const std::vector<std::uint8_t> &data)
+{
+    writeBigEndian(out, static_cast<std::uint32_t>(data.size()));
+    out.write(type, 4);
+    out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+    std::uint32_t crc = crc32(reinterpret_cast<const std::uint8_t *>(type), 4);
+    writeBigEndian(out, crc32(data.data(), data.size(), crc));
+}
+} // namespace
+
+PlacementRenderer::PlacementRenderer(int size, std::size_t max_outlines)
+    : size(std::max(1, size)), max_outlines(max_outlines)
+{
+}
+
+void PlacementRenderer::render(const std::vector<double> &x, const std::vector<double> &y,
+                               const std::vector<double> &width, const std::vector<double> &height)
+{
+    const std::size_t n = x.size();
+    pixels.assign(static_cast<std::size_t>(size) * size * 3, 0xFF);
+    boxes.clear();
+    coverage.clear();
+    density = n > max_outlines;
+    if (n == 0)
+    {
+        return;
+    }
+
+    double min_x = std::numeric_limits<double>::max();
+    double max_x = std::numeric_limits<double>::lowest();
+    double min_y = std::numeric_limits<double>::max();
+    double max_y = std::numeric_limits<double>::lowest();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        min_x = std::min(min_x, x[i]);
+        max_x = std::max(max_x, x[i] + width[i]);
+        min_y = std::min(min_y, y[i]);
+        max_y = std::max(max_y, y[i] + height[i]);
+    }
+
+    // Square view around the cells with 30% padding
+    double max_dim = std::max(max_x - min_x, max_y - min_y);
+    double half_range = max_dim > 0 ? max_dim * 1.3 / 2.0 : 1.0;
+    double left = (min_x + max_x) / 2.0 - half_range;
+    double top = (min_y + max_y) / 2.0 + half_range;
+    double scale = size / (2.0 * half_range);
+
+    if (density)
+    {
+        coverage.assign(static_cast<std::size_t>(size) * size, 0.0f);
+    }
+    else
+    {
+        boxes.reserve(n);
+    }
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        Box box{static_cast<float>((x[i] - left) * scale),
+                static_cast<float>((top - y[i] - height[i]) * scale),
+                static_cast<float>((x[i] + width[i] - left) * scale),
+                static_cast<float>((top - y[i]) * scale)};
+        if (density)
+        {
+            addCoverage(box);
+        }
+        else
+        {
+            boxes.push_back(box);
+            drawOutline(box);
+        }
+    }
+
+    if (density)
+    {
+        for (std::size_t p = 0; p < coverage.size(); ++p)
+        {
+            float t = std::min(1.0f, coverage[p]);
+            pixels[3 * p] = static_cast<std::uint8_t>(std::lround(0xFF + t * (kRed - 0xFF)));
+            pixels[3 * p + 1] = static_cast<std::uint8_t>(std::lround(0xFF + t * (kGreen - 0xFF)));
+            pixels[3 * p + 2] = static_cast<std::uint8_t>(std::lround(0xFF + t * (kBlue - 0xFF)));
+        }
+    }
+}
+
+void PlacementRenderer::setPixel(int px, int py, std::uint8_t r, std::uint8_t g, std::uint8_t b)
+{
+    if (px < 0 || py < 0 || px >= size || py >= size)
+    {
+        return;
+    }
+    std::size_t p = 3 * (static_cast<std::size_t>(py) * size + px);
+    pixels[p] = r;
+    pixels[p + 1] = g;
+    pixels[p + 2] = b;
+}
+
+// One-pixel border on the pixels the box edges fall in
+void PlacementRenderer::drawOutline(const Box &box)
+{
+    int x0 = static_cast<int>(std::floor(box.x0));
+    int y0 = static_cast<int>(std::floor(box.y0));
+    int x1 = std::max(x0, static_cast<int>(std::ceil(box.x1)) - 1);
+    int y1 = std::max(y0, static_cast<int>(std::ceil(box.y1)) - 1);
+    if (x1 < 0 || y1 < 0 || x0 >= size || y0 >= size)
+    {
+        return;
+    }
+    for (int px = std::max(x0, 0); px <= std::min(x1, size - 1); ++px)
+    {
+        setPixel(px, y0, kRed, kGreen, kBlue);
+        setPixel(px, y1, kRed, kGreen, kBlue);
+    }
+    for (int py = std::max(y0, 0); py <= std::min(y1, size - 1); ++py)
+    {
+        setPixel(x0, py, kRed, kGreen, kBlue);
+        setPixel(x1, py, kRed, kGreen, kBlue);
+    }
+}
+
+// Adds the area of the box inside each pixel it touches
+void PlacementRenderer::addCoverage(const Box &box)
+{
+    int x0 = std::max(0, static_cast<int>(std::floor(box.x0)));
+    int y0 = std::max(0, static_cast<int>(std::floor(box.y0)));
+    int x1 = std::min(size - 1, static_cast<int>(std::ceil(box.x1)) - 1);
+    int y1 = std::min(size - 1, static_cast<int>(std::ceil(box.y1)) - 1);
+    for (int py = y0; py <= y1; ++py)
+    {
+        float dy = std::min(box.y1, py + 1.0f) - std::max(box.y0, static_cast<float>(py));
+        for (int px = x0; px <= x1; ++px)
+        {
+            float dx = std::min(box.x1, px + 1.0f) - std::max(box.x0, static_cast<float>(px));
+            coverage[static_cast<std::size_t>(py) * size + px] += dx * dy;
+        }
+    }
+}
+
+// Truecolor PNG with the image data in stored (uncompressed) deflate blocks,
+// so no compression library is needed
+void PlacementRenderer::writePng(const std::string &path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open())
+    {
+        throw std::runtime_error("Cannot create image file: " + path);
+    }
+
+    std::vector<std::uint8_t> raw;
+    const std::size_t stride = static_cast<std::size_t>(size) * 3;
+    raw.reserve((stride + 1) * size);
+    for (int row = 0; row < size; ++row)
+    {
+        raw.push_back(0); // Filter type None
+        raw.insert(raw.end(), pixels.begin() + row * stride, pixels.begin() + (row + 1) * stride);
+    }
+
+    std::vector<std::uint8_t> zlib{0x78, 0x01};
+    for (std::size_t offset = 0; offset < raw.size();)
+    {
+        std::size_t length = std::min<std::size_t>(65535, raw.size() - offset);
+        zlib.push_back(offset + length == raw.size() ? 1 : 0);
+        zlib.push_back(static_cast<std::uint8_t>(length));
+        zlib.push_back(static_cast<std::uint8_t>(length >> 8));
+        zlib.push_back(static_cast<std::uint8_t>(~length));
+        zlib.push_back(static_cast<std::uint8_t>(~length >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+        offset += length;
+    }
+    std::uint32_t a = 1, b = 0;
+    for (std::uint8_t byte : raw)
+    {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    putBigEndian(zlib, (b << 16) | a);
+
+    std::vector<std::uint8_t> header;
+    putBigEndian(header, static_cast<std::uint32_t>(size));
+    putBigEndian(header, static_cast<std::uint32_t>(size));
+    header.insert(header.end(), {8, 2, 0, 0, 0}); // 8-bit RGB, no interlace
+
+    static const std::uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    out.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+    writeChunk(out, "IHDR", header);
+    writeChunk(out, "IDAT", zlib);
+    writeChunk(out, "IEND", {});
+    if (!out)
+    {
+        throw std::runtime_error("Cannot write image file: " + path);
+    }
+}
+
+// Outlines as rectangles, or the density as squares of kSvgBlock pixels
+void PlacementRenderer::writeSvg(const std::string &path) const
+{
+    std::ofstream out(path);
+    if (!out.is_open())
+    {
+        throw std::runtime_error("Cannot create image file: " + path);
+    }
+
+    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << size << "\" height=\"" << size
+        << "\" viewBox=\"0 0 " << size << " " << size << "\">\n";
+    out << "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n";
+    out << std::fixed << std::setprecision(2);
+    if (!density)
+    {
+        out << "<g fill=\"none\" stroke=\"#800080\" stroke-width=\"1\">\n";
+        for (const Box &box : boxes)
+        {
+            out << "<rect x=\"" << box.x0 << "\" y=\"" << box.y0 << "\" width=\"" << box.x1 - box.x0
+                << "\" height=\"" << box.y1 - box.y0 << "\"/>\n";
+        }
+    }
+    else
+    {
+        out << "<g fill=\"#800080\">\n";
+        for (int by = 0; by < size; by += kSvgBlock)
+        {
+            for (int bx = 0; bx < size; bx += kSvgBlock)
+            {
+                float sum = 0.0f;
+                int count = 0;
+                for (int py = by; py < std::min(size, by + kSvgBlock); ++py)
+                {
+                    for (int px = bx; px < std::min(size, bx + kSvgBlock); ++px)
+                    {
+                        sum += std::min(1.0f, coverage[static_cast<std::size_t>(py) * size + px]);
+                        ++count;
+                    }
+                }
+                if (sum > 0)
+                {
+                    out << "<rect x=\"" << bx << "\" y=\"" << by << "\" width=\"" << kSvgBlock << "\" height=\""
+                        << kSvgBlock << "\" fill-opacity=\"" << sum / count << "\"/>\n";
+                }
+            }
+        }
+    }
+    out << "</g>\n</svg>\n";
+    if (!out)
+    {
+        throw std::runtime_error("Cannot write image file: " + path);
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Draws a placement into a square RGB framebuffer and writes it as PNG or
+// SVG without external tools. The view is centred on the cells with 30%
+// padding, as the gnuplot plots were. Up to `max_outlines` cells are drawn
+// as purple outlines on white; a denser design is drawn as the cell area
+// covering each pixel, shaded from white to purple, since individual
+// outlines would merge anyway.
+class PlacementRenderer
+{
+public:
+    explicit PlacementRenderer(int size = 800, std::size_t max_outlines = 50000);
+
+    void render(const std::vector<double> &x, const std::vector<double> &y,
+                const std::vector<double> &width, const std::vector<double> &height);
+
+    // Throw std::runtime_error when the file cannot be written
+    void writePng(const std::string &path) const;
+    void writeSvg(const std::string &path) const;
+
+    bool isDensity() const { return density; }
+
+private:
+    // A cell in pixel coordinates, y downwards
+    struct Box
+    {
+        float x0, y0, x1, y1;
+    };
+
+    int size;
+    std::size_t max_outlines;
+    bool density = false;
+    std::vector<std::uint8_t> pixels; // RGB rows, top row first
+    std::vector<float> coverage;      // Cell area per pixel, in pixels, for density mode
+    std::vector<Box> boxes;           // Outline mode only
+
+    void setPixel(int px, int py, std::uint8_t r, std::uint8_t g, std::uint8_t b);
+    void drawOutline(const Box &box);
+    void addCoverage(const Box &box);
+};
@@ -0,0 +1,259 @@
+#include "region_legalizer.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+RegionLegalizer::RegionLegalizer(std::vector<AbacusRow> rows, int row_window, int regions, int threads,
+                                 int boundary_rows, double max_fill)
+    : rows(std::move(rows)), row_window(row_window), regions(std::max(1, regions)),
+      threads(std::max(1, threads)), boundary_rows(std::max(0, boundary_rows)), max_fill(max_fill)
+{
+}
+
+int RegionLegalizer::nearestRow(double y) const
+{
+    int above = static_cast<int>(
+        std::lower_bound(rows.begin(), rows.end(), y,
+                         [](const AbacusRow &row, double value)
+                         { return row.y < value; }) -
+        rows.begin());
+    if (above == static_cast<int>(rows.size()) ||
+        (above > 0 && y - rows[above - 1].y <= rows[above].y - y))
+    {
+        return above - 1;
+    }
+    return above;
+}
+
+std::vector<int> RegionLegalizer::legalizeRows(int first_row, int last_row, const std::vector<int> &cells,
+                                               const std::vector<double> &x, const std::vector<double> &y,
+                                               const std::vector<double> &width,
+                                               std::vector<double> &new_x, std::vector<double> &new_y) const
+{
+    std::vector<double> cell_x, cell_y, cell_width;
+    cell_x.reserve(cells.size());
+    cell_y.reserve(cells.size());
+    cell_width.reserve(cells.size());
+    for (int cell : cells)
+    {
+        cell_x.push_back(x[cell]);
+        cell_y.push_back(y[cell]);
+        cell_width.push_back(width[cell]);
+    }
+
+    AbacusLegalizer legalizer(std::vector<AbacusRow>(rows.begin() + first_row, rows.begin() + last_row),
+                              row_window);
+    return legalizer.legalize(cell_x, cell_y, cell_width, new_x, new_y);
+}
+
+std::vector<int> RegionLegalizer::legalize(const std::vector<double> &x, const std::vector<double> &y,
+                                           const std::vector<double> &width,
+                                           std::vector<double> &new_x, std::vector<double> &new_y)
+{
+    const int n = static_cast<int>(x.size());
+    const int num_rows = static_cast<int>(rows.size());
+    new_x = x;
+    new_y = y;
+    reconciled = 0;
+    if (num_rows == 0)
+    {
+        stripes = 0;
+        std::vector<int> all(n);
+        for (int i = 0; i < n; ++i)
+        {
+            all[i] = i;
+        }
+        return all;
+    }
+
+    // Stripes of equal row count, merged forward while too full
+    std::vector<double> demand(num_rows, 0.0), capacity(num_rows);
+    for (int i = 0; i < n; ++i)
+    {
+        demand[nearestRow(y[i])] += width[i];
+    }
+    for (int r = 0; r < num_rows; ++r)
+    {
+        capacity[r] = rows[r].max_x - rows[r].min_x;
+    }
+    const int initial = std::min(regions, num_rows);
+    std::vector<int> bounds{0};
+    double stripe_demand = 0.0, stripe_capacity = 0.0;
+    for (int k = 0; k < initial; ++k)
+    {
+        int end = static_cast<int>(static_cast<long long>(num_rows) * (k + 1) / initial);
+        for (int r = static_cast<int>(static_cast<long long>(num_rows) * k / initial); r < end; ++r)
+        {
+            stripe_demand += demand[r];
+            stripe_capacity += capacity[r];
+        }
+        if (stripe_demand <= max_fill * stripe_capacity || k == initial - 1)
+        {
+            // An overfull last stripe joins the one before it
+            if (stripe_demand > max_fill * stripe_capacity && bounds.size() > 1)
+            {
+                bounds.pop_back();
+            }
+            bounds.push_back(end);
+            stripe_demand = stripe_capacity = 0.0;
+        }
+    }
+
+    // Stripes on their own threads; each writes only its own cells. A stripe
+    // where some cell fits in no row is merged with its less filled neighbour
+    // and run again, and the stripes that succeeded keep their result. At
+    // worst this ends in a single stripe, which is plain Abacus.
+    auto fillOf = [&](int first_row, int last_row)
+    {
+        double used = 0.0, total = 0.0;
+        for (int r = first_row; r < last_row; ++r)
+        {
+            used += demand[r];
+            total += capacity[r];
+        }
+        return total > 0.0 ? used / total : 1.0;
+    };
+
+    std::vector<int> stripe_of_row(num_rows);
+    std::vector<std::vector<int>> failed;
+    std::vector<char> pending(bounds.size() - 1, 1);
+    while (true)
+    {
+        stripes = static_cast<int>(bounds.size()) - 1;
+        for (int s = 0; s < stripes; ++s)
+        {
+            std::fill(stripe_of_row.begin() + bounds[s], stripe_of_row.begin() + bounds[s + 1], s);
+        }
+        std::vector<std::vector<int>> stripe_cells(stripes);
+        for (int i = 0; i < n; ++i)
+        {
+            stripe_cells[stripe_of_row[nearestRow(y[i])]].push_back(i);
+        }
+
+        failed.assign(stripes, {});
+        runParallel(stripes, threads, [&](int s)
+                    {
+                        if (!pending[s])
+                        {
+                            return;
+                        }
+                        const std::vector<int> &cells = stripe_cells[s];
+                        std::vector<double> placed_x, placed_y;
+                        for (int k : legalizeRows(bounds[s], bounds[s + 1], cells, x, y, width, placed_x, placed_y))
+                        {
+                            failed[s].push_back(cells[k]);
+                        }
+                        for (std::size_t k = 0; k < cells.size(); ++k)
+                        {
+                            new_x[cells[k]] = placed_x[k];
+                            new_y[cells[k]] = placed_y[k];
+                        }
+                    });
+
+        // Bound b separates stripes b - 1 and b
+        std::vector<char> drop(bounds.size(), 0);
+        bool merging = false;
+        for (int s = 0; s < stripes && stripes > 1; ++s)
+        {
+            if (failed[s].empty())
+            {
+                continue;
+            }
+            bool next = s == 0 ||
+                        (s + 1 < stripes && fillOf(bounds[s + 1], bounds[s + 2]) < fillOf(bounds[s - 1], bounds[s]));
+            drop[next ? s + 1 : s] = 1;
+            merging = true;
+        }
+        if (!merging)
+        {
+            break;
+        }
+
+        // Only stripes that absorbed another run again
+        std::vector<int> merged_bounds{0};
+        std::vector<char> merged_pending;
+        int parts = 0;
+        for (int b = 1; b <= stripes; ++b)
+        {
+            ++parts;
+            if (drop[b])
+            {
+                continue;
+            }
+            merged_pending.push_back(parts > 1 ? 1 : 0);
+            merged_bounds.push_back(bounds[b]);
+            parts = 0;
+        }
+        bounds.swap(merged_bounds);
+        pending.swap(merged_pending);
+    }
+
+    std::vector<int> unplaced;
+    std::vector<char> is_unplaced(n, 0);
+    for (const auto &cells : failed)
+    {
+        for (int cell : cells)
+        {
+            unplaced.push_back(cell);
+            is_unplaced[cell] = 1;
+        }
+    }
+    std::sort(unplaced.begin(), unplaced.end());
+    if (stripes == 1 || boundary_rows == 0)
+    {
+        return unplaced;
+    }
+
+    // Boundary windows take at most half of each neighbouring stripe, so no
+    // two of them share a row
+    const int windows = stripes - 1;
+    std::vector<int> window_first(windows), window_last(windows);
+    std::vector<int> window_of_row(num_rows, -1);
+    for (int w = 0; w < windows; ++w)
+    {
+        int boundary = bounds[w + 1];
+        window_first[w] = std::max(boundary - boundary_rows, boundary - (boundary - bounds[w]) / 2);
+        window_last[w] = std::min(boundary + boundary_rows, boundary + (bounds[w + 2] - boundary) / 2);
+        std::fill(window_of_row.begin() + window_first[w], window_of_row.begin() + window_last[w], w);
+    }
+    std::vector<std::vector<int>> window_cells(windows);
+    for (int i = 0; i < n; ++i)
+    {
+        int w = is_unplaced[i] ? -1 : window_of_row[nearestRow(new_y[i])];
+        if (w != -1)
+        {
+            window_cells[w].push_back(i);
+        }
+    }
+
+    std::vector<char> kept(windows, 0);
+    runParallel(windows, threads, [&](int w)
+                {
+                    const std::vector<int> &cells = window_cells[w];
+                    std::vector<double> placed_x, placed_y;
+                    if (cells.empty() ||
+                        !legalizeRows(window_first[w], window_last[w], cells, x, y, width, placed_x, placed_y).empty())
+                    {
+                        return;
+                    }
+                    double before = 0.0, after = 0.0;
+                    for (std::size_t k = 0; k < cells.size(); ++k)
+                    {
+                        int cell = cells[k];
+                        before += std::abs(new_x[cell] - x[cell]) + std::abs(new_y[cell] - y[cell]);
+                        after += std::abs(placed_x[k] - x[cell]) + std::abs(placed_y[k] - y[cell]);
+                    }
+                    if (after < before)
+                    {
+                        for (std::size_t k = 0; k < cells.size(); ++k)
+                        {
+                            new_x[cells[k]] = placed_x[k];
+                            new_y[cells[k]] = placed_y[k];
+                        }
+                        kept[w] = 1;
+                    }
+                });
+    reconciled = static_cast<int>(std::count(kept.begin(), kept.end(), 1));
+    return unplaced;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "abacus.hpp"
+#include <vector>
+
+// Abacus legalization split into horizontal stripes of rows that are
+// legalized on their own threads. Each cell goes to the stripe of its nearest
+// row; a stripe whose cells would fill it beyond `max_fill` is merged with the
+// next one beforehand. A stripe where a cell still fits in no row is merged
+// with its less filled neighbour and legalized again, until every cell fits
+// or one stripe is left, which is plain Abacus; so no cell is left unplaced
+// that serial Abacus would place. Cells cannot leave their stripe, so a
+// reconciliation pass then legalizes again the `boundary_rows` rows on either
+// side of each stripe boundary, with the cells found there, and keeps the new
+// positions when they move those cells less. Boundary windows do not share
+// rows and also run in parallel.
+//
+// The stripes depend only on `regions`, never on `threads`, so the result is
+// the same for any thread count. One region is plain AbacusLegalizer.
+class RegionLegalizer
+{
+public:
+    RegionLegalizer(std::vector<AbacusRow> rows, int row_window, int regions, int threads,
+                    int boundary_rows = 16, double max_fill = 0.9);
+
+    // Same contract as AbacusLegalizer::legalize
+    std::vector<int> legalize(const std::vector<double> &x, const std::vector<double> &y,
+                              const std::vector<double> &width,
+                              std::vector<double> &new_x, std::vector<double> &new_y);
+
+    // Stripes after merging, and boundary windows whose result was kept
+    int getStripes() const { return stripes; }
+    int getReconciled() const { return reconciled; }
+
+private:
+    std::vector<AbacusRow> rows;
+    int row_window;
+    int regions;
+    int threads;
+    int boundary_rows;
+    double max_fill;
+    int stripes = 0;
+    int reconciled = 0;
+
+    int nearestRow(double y) const;
+
+    // Legalizes `cells` on rows [first_row, last_row). new_x[k]/new_y[k] is
+    // the position of cells[k]; returns the k that did not fit.
+    std::vector<int> legalizeRows(int first_row, int last_row, const std::vector<int> &cells,
+                                  const std::vector<double> &x, const std::vector<double> &y,
+                                  const std::vector<double> &width,
+                                  std::vector<double> &new_x, std::vector<double> &new_y) const;
+};
@@ -0,0 +1,263 @@
+#include "site_rows.hpp"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+FreeSites::FreeSites(int num_sites)
+{
+    int blocks = std::max(1, (num_sites + kBlock - 1) / kBlock);
+    leaves = 1;
+    while (leaves < blocks)
+    {
+        leaves *= 2;
+    }
+    tree.assign(2 * leaves, 0);
+    if (num_sites > 0)
+    {
+        spans[0] = num_sites;
+        free_sites = num_sites;
+        updateBlock(0);
+    }
+}
+
+void FreeSites::updateBlock(int block)
+{
+    int start = block * kBlock;
+    int best = 0;
+    for (auto it = spans.lower_bound(start); it != spans.end() && it->first < start + kBlock; ++it)
+    {
+        best = std::max(best, it->second - it->first);
+    }
+    int i = leaves + block;
+    tree[i] = best;
+    for (i /= 2; i > 0; i /= 2)
+    {
+        tree[i] = std::max(tree[2 * i], tree[2 * i + 1]);
+    }
+}
+
+void FreeSites::occupy(int begin, int end)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    auto it = spans.upper_bound(begin);
+    if (it != spans.begin() && std::prev(it)->second > begin)
+    {
+        --it;
+    }
+
+    std::vector<int> blocks;
+    while (it != spans.end() && it->first < end)
+    {
+        int span_begin = it->first;
+        int span_end = it->second;
+        it = spans.erase(it);
+        free_sites -= std::min(span_end, end) - std::max(span_begin, begin);
+        blocks.push_back(span_begin / kBlock);
+        if (span_begin < begin)
+        {
+            spans[span_begin] = begin;
+        }
+        if (span_end > end)
+        {
+            spans[end] = span_end;
+            blocks.push_back(end / kBlock);
+        }
+    }
+
+    std::sort(blocks.begin(), blocks.end());
+    blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+    for (int block : blocks)
+    {
+        updateBlock(block);
+    }
+}
+
+int FreeSites::firstBlock(int from, int width) const
+{
+    if (from >= leaves)
+    {
+        return -1;
+    }
+    int i = std::max(0, from) + leaves;
+    while (true)
+    {
+        if (tree[i] >= width)
+        {
+            while (i < leaves)
+            {
+                i = tree[2 * i] >= width ? 2 * i : 2 * i + 1;
+            }
+            return i - leaves;
+        }
+        // Climb to the next subtree on the right
+        while (i & 1)
+        {
+            i >>= 1;
+        }
+        if (i == 0)
+        {
+            return -1;
+        }
+        ++i;
+    }
+}
+
+int FreeSites::lastBlock(int to, int width) const
+{
+    if (to < 0)
+    {
+        return -1;
+    }
+    int i = std::min(to, leaves - 1) + leaves;
+    while (true)
+    {
+        if (tree[i] >= width)
+        {
+            while (i < leaves)
+            {
+                i = tree[2 * i + 1] >= width ? 2 * i + 1 : 2 * i;
+            }
+            return i - leaves;
+        }
+        // Climb to the next subtree on the left
+        while (!(i & 1))
+        {
+            i >>= 1;
+        }
+        if (i == 1)
+        {
+            return -1;
+        }
+        --i;
+    }
+}
+
+int FreeSites::nearest(int site, int width) const
+{
+    if (width <= 0 || longest() < width)
+    {
+        return -1;
+    }
+
+    int best = -1;
+    int best_distance = INT_MAX;
+    auto consider = [&](int span_begin, int span_end)
+    {
+        int start = std::max(span_begin, std::min(site, span_end - width));
+        int distance = std::abs(start - site);
+        if (distance < best_distance)
+        {
+            best = start;
+            best_distance = distance;
+        }
+    };
+
+    const int home = std::min(std::max(site, 0) / kBlock, leaves - 1);
+
+    // Left: the last span that fits and begins at or before `site`
+    for (int block = home; block >= 0; block = lastBlock(block - 1, width))
+    {
+        auto it = spans.upper_bound(std::min(site, block * kBlock + kBlock - 1));
+        bool found = false;
+        while (it != spans.begin())
+        {
+            --it;
+            if (it->first < block * kBlock)
+            {
+                break;
+            }
+            if (it->second - it->first >= width)
+            {
+                consider(it->first, it->second);
+                found = true;
+                break;
+            }
+        }
+        if (found)
+        {
+            break;
+        }
+    }
+
+    // Right: the first span that fits and begins after `site`
+    for (int block = home; block >= 0; block = firstBlock(block + 1, width))
+    {
+        auto it = spans.upper_bound(std::max(site, block * kBlock - 1));
+        bool found = false;
+        for (; it != spans.end() && it->first < block * kBlock + kBlock; ++it)
+        {
+            if (it->second - it->first >= width)
+            {
+                consider(it->first, it->second);
+                found = true;
+                break;
+            }
+        }
+        if (found)
+        {
+            break;
+        }
+    }
+    return best;
+}
+
+int SiteRow::sitesFor(double width) const
+{
+    return std::max(1, static_cast<int>(std::ceil(width / spacing - 1e-9)));
+}
+
+int SiteRow::siteAt(double x, int sites) const
+{
+    int site = static_cast<int>(std::lround((x - origin) / spacing));
+    return std::max(0, std::min(site, num_sites - sites));
+}
+
+std::vector<SiteRow> buildSiteRows(const BookshelfDesign &design)
+{
+    std::vector<SiteRow> rows;
+    rows.reserve(design.rows.size());
+    double max_height = 0.0;
+    for (const BookshelfRow &row : design.rows)
+    {
+        double spacing = row.site_spacing > 0 ? row.site_spacing : row.site_width;
+        if (spacing <= 0)
+        {
+            spacing = 1.0;
+        }
+        rows.push_back({row.coordinate, row.height, row.subrow_origin, spacing, row.num_sites,
+                        FreeSites(row.num_sites)});
+        max_height = std::max(max_height, row.height);
+    }
+    std::sort(rows.begin(), rows.end(), [](const SiteRow &a, const SiteRow &b)
+              { return a.y < b.y || (a.y == b.y && a.origin < b.origin); });
+
+    // Fixed and terminal nodes take the sites they cover in every row they cross
+    for (std::size_t i = 0; i < design.nodes.size(); ++i)
+    {
+        const BookshelfNode &node = design.nodes[i];
+        const BookshelfPlacement &placement = design.placements[i];
+        if (!(node.is_terminal || placement.is_fixed) || node.width <= 0 || node.height <= 0)
+        {
+            continue;
+        }
+        auto first = std::lower_bound(rows.begin(), rows.end(), placement.y - max_height,
+                                      [](const SiteRow &row, double y)
+                                      { return row.y < y; });
+        for (auto row = first; row != rows.end() && row->y < placement.y + node.height; ++row)
+        {
+            if (row->y + row->height <= placement.y)
+            {
+                continue;
+            }
+            int begin = static_cast<int>(std::floor((placement.x - row->origin) / row->spacing));
+            int end = static_cast<int>(std::ceil((placement.x + node.width - row->origin) / row->spacing));
+            row->free.occupy(std::max(begin, 0), std::min(end, row->num_sites));
+        }
+    }
+    return rows;
+}
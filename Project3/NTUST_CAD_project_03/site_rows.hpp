@@ -0,0 +1,60 @@
+#pragma once
+#include "bookshelf.hpp"
+#include <map>
+#include <vector>
+
+// Free sites of one subrow as disjoint spans [begin, end) in site units.
+// Besides the span map, a max-tree over blocks of kBlock sites holds the
+// longest span starting in each block, so the nearest span that fits a cell
+// is found in O(log n) without walking past spans that are too short.
+class FreeSites
+{
+public:
+    explicit FreeSites(int num_sites = 0);
+
+    // Marks [begin, end) as used; the range may include used sites
+    void occupy(int begin, int end);
+
+    // First site of the free run of `width` sites that starts nearest to
+    // `site`, or -1 when no span is long enough
+    int nearest(int site, int width) const;
+
+    int longest() const { return tree.empty() ? 0 : tree[1]; }
+    int freeSites() const { return free_sites; }
+    const std::map<int, int> &getSpans() const { return spans; }
+
+private:
+    static constexpr int kBlock = 32;
+
+    std::map<int, int> spans; // begin -> end
+    std::vector<int> tree;    // tree[leaves + b]: longest span starting in block b
+    int leaves = 0;
+    int free_sites = 0;
+
+    void updateBlock(int block);
+    int firstBlock(int from, int width) const; // Leftmost block >= from with a fit, or -1
+    int lastBlock(int to, int width) const;    // Rightmost block <= to with a fit, or -1
+};
+
+// One CoreRow of the .scl file: sites at origin + k * spacing, k < num_sites
+struct SiteRow
+{
+    double y;
+    double height;
+    double origin;
+    double spacing;
+    int num_sites;
+    FreeSites free;
+
+    double siteX(int site) const { return origin + site * spacing; }
+    double maxX() const { return origin + num_sites * spacing; }
+
+    // Sites a cell of `width` covers, rounded up
+    int sitesFor(double width) const;
+    // Site nearest to x where a cell of `sites` sites still fits in the row
+    int siteAt(double x, int sites) const;
+};
+
+// Subrows of the design sorted by y and then origin, with the sites under
+// fixed and terminal nodes already taken
+std::vector<SiteRow> buildSiteRows(const BookshelfDesign &design);